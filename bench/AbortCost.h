@@ -0,0 +1,143 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2005, 2006
+// University of Rochester
+// Department of Computer Science
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//    * Redistributions of source code must retain the above copyright notice,
+//      this list of conditions and the following disclaimer.
+//
+//    * Redistributions in binary form must reproduce the above copyright
+//      notice, this list of conditions and the following disclaimer in the
+//      documentation and/or other materials provided with the distribution.
+//
+//    * Neither the name of the University of Rochester nor the names of its
+//      contributors may be used to endorse or promote products derived from
+//      this software without specific prior written permission.
+//
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+
+#ifndef __BENCH_ABORTCOST_H__
+#define __BENCH_ABORTCOST_H__
+
+#include <stm_api.h>
+
+#include "Benchmark.h"
+#include "Counter.h"
+
+namespace bench
+{
+    /**
+     *  Measures what an abort costs.  Every transaction reads a counter and
+     *  then restarts itself ABORTS times, DEPTH calls below the transaction
+     *  body, before it is allowed to commit.  Nearly all of its time goes to
+     *  leaving the body and starting over, so comparing a build with
+     *  ABORT_MECHANISM=EXCEPTION against one with ABORT_MECHANISM=LONGJMP
+     *  gives the cost of each mechanism.  cgl can't restart a transaction, so
+     *  under cgl this is a single read.
+     */
+    class AbortCost : public Benchmark
+    {
+      private:
+
+        static const int ABORTS = 4;
+        static const int DEPTH = 8;
+
+        stm::sh_ptr<Counter> m_counter;
+
+        // restart the transaction /depth/ frames below the caller, unless
+        // this is its last /attempt/.  The volatile read after the call
+        // keeps the frames from being folded into a loop.
+        static int restartFrom(int depth, int attempt)
+        {
+            volatile int frame = depth;
+            if (depth > 0)
+                restartFrom(depth - 1, attempt);
+            else if (attempt < ABORTS)
+                stm::restart();
+            return frame;
+        }
+
+        // read the counter
+        int value() const
+        {
+            int val = -1;
+            BEGIN_RO_TRANSACTION;
+            stm::rd_ptr<Counter> rd(m_counter);
+            val = rd->get_value(rd.v());
+            END_TRANSACTION;
+            return val;
+        }
+
+        // bump the counter, then restart like random_transaction does
+        void bumpAndRestart()
+        {
+            volatile int attempts = 0;
+
+            BEGIN_TRANSACTION;
+            stm::wr_ptr<Counter> wr(m_counter);
+            wr->increment(wr.v());
+            if (attempts < ABORTS)
+                restartFrom(DEPTH, attempts++);
+            END_TRANSACTION;
+        }
+
+      public:
+
+        AbortCost() : m_counter(new Counter()) { }
+
+
+        void random_transaction(thread_args_t* args,
+                                unsigned int* seed,
+                                unsigned int val,
+                                unsigned int chance)
+        {
+            // changed inside the transaction and read after a rollback
+            volatile int attempts = 0;
+
+            BEGIN_TRANSACTION;
+            stm::rd_ptr<Counter> rd(m_counter);
+            rd->get_value(rd.v());
+            if (attempts < ABORTS)
+                restartFrom(DEPTH, attempts++);
+            END_TRANSACTION;
+        }
+
+
+        bool sanity_check() const
+        {
+            return (value() == 0);
+        }
+
+
+        // every transaction bumps the counter before each restart, so only
+        // the bump of the attempt that commits may survive the rollbacks
+        virtual bool verify(VerifyLevel_t v)
+        {
+            int start = value();
+            int N = (v == HEAVY) ? 65536 : 256;
+            for (int i = 0; i < N; i++)
+                bumpAndRestart();
+            return (value() == start + N);
+        }
+    };
+
+}   // namespace bench
+
+#endif  // __BENCH_ABORTCOST_H__
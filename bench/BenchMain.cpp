@@ -44,6 +44,7 @@
 #include <iostream>
 
 #include "Benchmark.h"
+#include "AbortCost.h"
 #include "Counter.h"
 #include "FGL.h"
 #include "CGHash.h"
@@ -54,6 +55,7 @@
 #include "PrivList.h"
 #include "RBTree.h"
 #include "RBTreeLarge.h"
+#include "RBTreeChunked.h"
 #include "RandomGraphList.h"
 
 #ifdef USE_BIMODAL
@@ -82,6 +84,8 @@ static void usage()
     cerr << "    HashTable          256-bucket hash table" << endl;
     cerr << "    RBTree (default)   Red-black tree" << endl;
     cerr << "    RBTreeLarge        Red-black tree with 4KB nodes" << endl;
+    cerr << "    RBTreeChunked      RBTreeLarge, payload in 256B chunks"
+         << endl;
     cerr << "    LFUCache           Web cache simulation" << endl;
     cerr << "    RandomGraph        Graph with 4 connections per node" << endl;
     cerr << "    PrivList           Linked list privatization test" << endl;
@@ -90,6 +94,8 @@ static void usage()
          << endl;
     cerr << "    FineGrainHash      256-bucket hash table, per-bucket locks"
          << endl;
+    cerr << "    AbortCost          Self-aborting reads, for abort cost"
+         << endl;
     cerr << endl;
     cerr << "  Contention Managers:" << endl;
     cerr << "     Polka (default), Eruption, Highlander, Karma, Killblocked, ";
@@ -98,13 +104,21 @@ static void usage()
     cerr << "Polkavis" << endl;
     cerr << endl;
     cerr << "  Validation Strategies:" << endl;
-    cerr << "     invis-eager (default), invis-lazy, vis-eager, vis-lazy ";
+    cerr << "     invis-eager (default), invis-lazy, vis-eager, vis-lazy, ";
     cerr << endl;
+    cerr << "     clock-eager, clock-lazy, adaptive (rstm only)" << endl;
     cerr << endl;
     cerr << "  Flags:" << endl;
     cerr << "    -d: number of seconds to time (default 5)" << endl;
     cerr << "    -m: number of distinct elements (default 256)" << endl;
     cerr << "    -p: number of threads (default 2)" << endl;
+    cerr << "    -F: consecutive aborts before a transaction takes the"
+         << endl;
+    cerr << "        fallback lock, 0 for never (rstm only)" << endl;
+    cerr << "    -K: backoff for every CM and between retries: spin,"
+         << endl;
+    cerr << "        exponential, yield or park (default: each CM's own)"
+         << endl;
     cerr << endl;
     cerr << "  Other:" << endl;
     cerr << "    -h: print help (this message)" << endl;
@@ -125,7 +139,7 @@ int main(int argc, char** argv)
     int opt;
 
     // parse the command-line options
-    while ((opt = getopt(argc, argv, "B:C:H:a:d:m:p:hqv!xV:1234T:W:X:")) != -1)
+    while ((opt = getopt(argc, argv, "B:C:F:H:K:a:d:m:p:hqv!xV:1234T:W:X:")) != -1)
     {
         switch(opt) {
           case 'B':
@@ -141,6 +155,12 @@ int main(int argc, char** argv)
             BMCONFIG.cm_type = string(optarg);
             BMCONFIG.use_static_cm = false;
             break;
+          case 'F':
+            BMCONFIG.fallback = atoi(optarg);
+            break;
+          case 'K':
+            BMCONFIG.backoff = string(optarg);
+            break;
           case 'W':
             BMCONFIG.warmup = atoi(optarg);
             break;
@@ -191,6 +211,10 @@ int main(int argc, char** argv)
     // make sure that the parameters all make sense
     BMCONFIG.verifyParameters();
 
+    if (BMCONFIG.fallback >= 0)
+        stm::set_fallback_threshold(BMCONFIG.fallback);
+    stm::set_backoff_strategy(BMCONFIG.backoff);
+
     // initialize stm so that we have transactional mm, then verify the
     // benchmark parameter and construct the benchmark object
     stm::init(BMCONFIG.cm_type, BMCONFIG.stm_validation,
@@ -227,6 +251,10 @@ int main(int argc, char** argv)
         B = new IntSetBench(new RBTree(), BMCONFIG.datasetsize);
     else if (BMCONFIG.bm_name == "RBTreeLarge")
         B = new IntSetBench(new RBTreeLarge(), BMCONFIG.datasetsize);
+    else if (BMCONFIG.bm_name == "RBTreeChunked")
+        B = new IntSetBench(new RBTreeChunked(), BMCONFIG.datasetsize);
+    else if (BMCONFIG.bm_name == "AbortCost")
+        B = new AbortCost();
     else
         argError("Unrecognized benchmark name " + BMCONFIG.bm_name);
 
@@ -295,11 +295,22 @@ void BenchmarkConfig::verifyParameters()
         argError("p must be positive");
     if ((stm_validation != "vis-eager") && (stm_validation != "vis-lazy") &&
         (stm_validation != "invis-eager") && (stm_validation != "mixed") &&
-        (stm_validation != "invis-lazy"))
+        (stm_validation != "invis-lazy") &&
+        (stm_validation != "clock-eager") && (stm_validation != "clock-lazy") &&
+        (stm_validation != "adaptive"))
         argError("Invalid validation strategy");
+#ifndef SCALABLE_READERS
     if ((stm_validation == "vis-eager" || stm_validation == "vis-lazy") &&
         (threads > 31))
-        argError("only up to 31 visible readers are currently supported");
+        argError("only up to 31 visible readers are supported without "
+                 "SCALABLE_READERS=on");
+#endif
+    if (fallback < -1)
+        argError("F must not be negative");
+    if ((backoff != "") && (backoff != "spin") &&
+        (backoff != "exponential") && (backoff != "yield") &&
+        (backoff != "park"))
+        argError("Invalid backoff strategy " + backoff);
     if (unit_testing != 'l' && unit_testing != 'h' && unit_testing != ' ')
         argError("Invalid unit testing parameter: " + unit_testing);
 }
@@ -314,5 +325,9 @@ void BenchmarkConfig::printConfig()
              << datasetsize
              << " elements, " << threads << " thread(s)" << endl;
         cout << "Validation Strategy: " << stm_validation << endl;
+        if (fallback >= 0)
+            cout << "Fallback after " << fallback << " aborts" << endl;
+        if (backoff != "")
+            cout << "Backoff: " << backoff << endl;
     }
 }
@@ -66,13 +66,18 @@ struct BenchmarkConfig
     int warmup;
     int execute;
     char unit_testing;
+    // consecutive aborts before the fallback lock, -1 for the library default
+    int fallback;
+    // backoff strategy for every CM, "" for each CM's own
+    std::string backoff;
 
     BenchmarkConfig()
         : duration(5), datasetsize(256), threads(2), verbosity(1),
           verify(true), cm_type("Polka"), bm_name("RBTree"),
           stm_validation("invis-eager"), use_static_cm(true),
           NUM_OUTCOMES(30), lThresh(10), iThresh(20),
-          warmup(0), execute(0), unit_testing(' ') { }
+          warmup(0), execute(0), unit_testing(' '), fallback(-1),
+          backoff("") { }
 
     void verifyParameters();
     void printConfig();
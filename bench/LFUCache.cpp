@@ -50,12 +50,12 @@ namespace bench
     static const int heapSize = ((1 << (heapDepth + 1)) - 1);
 
     // defines each node in the priority heap of the LFUCache
-    class PriorityHeapNode : public Object<PriorityHeapNode>
+    class PriorityHeapNode : public InPlaceObject<PriorityHeapNode>
     {
-        GENERATE_FIELD(int, value);
-        GENERATE_FIELD(int, frequencyCount);
-        GENERATE_FIELD(sh_ptr<PriorityHeapNode>, left);
-        GENERATE_FIELD(sh_ptr<PriorityHeapNode>, right);
+        GENERATE_UNDO_FIELD(int, value);
+        GENERATE_UNDO_FIELD(int, frequencyCount);
+        GENERATE_UNDO_FIELD(sh_ptr<PriorityHeapNode>, left);
+        GENERATE_UNDO_FIELD(sh_ptr<PriorityHeapNode>, right);
       public:
 
         PriorityHeapNode(int _value = 0,
@@ -105,10 +105,10 @@ namespace bench
 
 
     // table entries point to elements in the heap
-    class TableEntry : public Object<TableEntry>
+    class TableEntry : public InPlaceObject<TableEntry>
     {
-        GENERATE_FIELD(int, value);
-        GENERATE_FIELD(sh_ptr<PriorityHeapNode>, heapPtr);
+        GENERATE_UNDO_FIELD(int, value);
+        GENERATE_UNDO_FIELD(sh_ptr<PriorityHeapNode>, heapPtr);
       public:
 
         TableEntry(int _value = 0)
@@ -299,7 +299,8 @@ namespace bench
         {
             bool sane = false;
 
-            BEGIN_TRANSACTION;
+            // reads the whole heap, so don't let writers keep aborting it
+            BEGIN_IRREVOCABLE_TRANSACTION;
 
             sane = true;
 
@@ -48,7 +48,8 @@ bool LinkedList::isSane(void) const
 {
     bool sane = false;
 
-    BEGIN_TRANSACTION;
+    // reads the whole list, so don't let writers keep aborting it
+    BEGIN_IRREVOCABLE_TRANSACTION;
 
     sane = true;
     rd_ptr<LLNode> prev(sentinel);
@@ -135,7 +136,7 @@ bool LinkedList::lookup(int val) const
 {
     bool found = false;
 
-    BEGIN_TRANSACTION;
+    BEGIN_RO_TRANSACTION;
 
     rd_ptr<LLNode> curr(sentinel);
     curr = curr->get_next(curr.v());
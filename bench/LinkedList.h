@@ -41,8 +41,10 @@
 
 namespace bench
 {
-    // LLNode is a single node in a sorted linked list
-    class LLNode : public stm::Object<LLNode>
+    // LLNode is a single node in a sorted linked list.  Nodes are validated
+    // by value, so that readers of a hot node (the sentinel at the head of
+    // each Hash bucket, mostly) survive writes that leave it unchanged
+    class LLNode : public stm::ValueValidatedObject<LLNode>
     {
         GENERATE_FIELD(int, val);
         GENERATE_FIELD(stm::sh_ptr<LLNode>, next);
@@ -68,6 +70,12 @@ namespace bench
             return new LLNode(val, next);
         }
 
+        // two versions of a node are interchangeable if their fields agree
+        bool operator==(const LLNode& other) const
+        {
+            return m_val == other.m_val && m_next == other.m_next;
+        }
+
 #ifdef NEED_REDO_METHOD
         virtual void redo(SharedBase* l_sh)
         {
@@ -207,7 +207,7 @@ bool LinkedListBM::lookup2(int val) const
 {
     bool found = false;
 
-    BEGIN_TRANSACTION;
+    BEGIN_RO_TRANSACTION;
 
     rd_ptr<LLNode> curr(sentinel);
     curr = curr->get_next(curr.v());
@@ -107,7 +107,7 @@ bool LinkedListRelease::lookup(int val) const
 {
     bool found = false;
 
-    BEGIN_TRANSACTION;
+    BEGIN_RO_TRANSACTION;
 
     rd_ptr<LLNode> prev(sentinel);
     rd_ptr<LLNode> curr(prev->get_next(prev.v()));
@@ -87,7 +87,7 @@ bool RBTree::lookup(int v) const
 {
     bool found = false;
 
-    BEGIN_TRANSACTION;
+    BEGIN_RO_TRANSACTION;
     found = false;
     // find v
     rd_ptr<RBNode> sentinel_r(sentinel);
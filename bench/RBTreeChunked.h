@@ -0,0 +1,130 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2005, 2006
+// University of Rochester
+// Department of Computer Science
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//    * Redistributions of source code must retain the above copyright notice,
+//      this list of conditions and the following disclaimer.
+//
+//    * Redistributions in binary form must reproduce the above copyright
+//      notice, this list of conditions and the following disclaimer in the
+//      documentation and/or other materials provided with the distribution.
+//
+//    * Neither the name of the University of Rochester nor the names of its
+//      contributors may be used to endorse or promote products derived from
+//      this software without specific prior written permission.
+//
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef __BENCH_RB_TREE_CHUNKED_H__
+#define __BENCH_RB_TREE_CHUNKED_H__
+
+#include <stm_api.h>
+#include "IntSet.h"
+
+namespace bench
+{
+    // the 4KB payload of an RBNodeLarge, cut into 256-byte chunks
+    static const int CHUNK_INTS = 64;
+    static const int PAYLOAD_CHUNKS = 1024 / CHUNK_INTS;
+
+    // One chunk of a node's payload.  Each chunk is a transactional object of
+    // its own, so a writer clones only the chunks it opens for writing, and
+    // transactions that touch different chunks of a node don't conflict.
+    class PayloadChunk : public stm::Object<PayloadChunk>
+    {
+        GENERATE_ARRAY(int, word, CHUNK_INTS);
+      public:
+        PayloadChunk(int first = 0)
+        {
+            for (int i = 0; i < CHUNK_INTS; i++)
+                m_word[i] = first + i;
+        }
+
+        virtual PayloadChunk* clone() const
+        {
+            return new PayloadChunk(*this);
+        }
+
+#ifdef NEED_REDO_METHOD
+        virtual void redo(stm::internal::SharedBase* c_sh)
+        {
+            PayloadChunk* c = static_cast<PayloadChunk*>(c_sh);
+            for (int i = 0; i < CHUNK_INTS; i++)
+                m_word[i] = c->m_word[i];
+        }
+#endif
+    };
+
+    // Same as RBNodeLarge, but the payload sits behind an indirection table
+    // of chunks.  Cloning the node copies the table, not the payload.
+    class RBNodeChunked : public stm::Object<RBNodeChunked>
+    {
+        GENERATE_FIELD(Color, color);
+        GENERATE_FIELD(int, val);
+        // invariant: parent->child[ID] == this
+        GENERATE_FIELD(stm::sh_ptr<RBNodeChunked>, parent);
+        GENERATE_FIELD(int, ID);
+        GENERATE_ARRAY(stm::sh_ptr<RBNodeChunked>, child, 2);
+        GENERATE_ARRAY(stm::sh_ptr<PayloadChunk>, chunk, PAYLOAD_CHUNKS);
+      public:
+        RBNodeChunked();
+
+        virtual RBNodeChunked* clone() const
+        {
+            return new RBNodeChunked(*this);
+        }
+
+#ifdef NEED_REDO_METHOD
+        virtual void redo(stm::internal::SharedBase* n_sh)
+        {
+            RBNodeChunked* n = static_cast<RBNodeChunked*>(n_sh);
+            m_color = n->m_color;
+            m_val = n->m_val;
+            m_parent = n->m_parent;
+            m_ID = n->m_ID;
+            m_child[0] = n->m_child[0];
+            m_child[1] = n->m_child[1];
+            for (int i = 0; i < PAYLOAD_CHUNKS; i++)
+                m_chunk[i] = n->m_chunk[i];
+        }
+#endif
+    };
+
+    // set of RBNodeChunked objects
+    class RBTreeChunked : public IntSet
+    {
+      public:
+        stm::sh_ptr<RBNodeChunked> sentinel;
+
+        RBTreeChunked();
+
+        // standard IntSet methods
+        virtual bool lookup(int val) const;
+        virtual void insert(int val);
+        virtual void remove(int val);
+        virtual bool isSane() const; // returns true iff invariants hold
+
+        // for debugging only
+        virtual void print(int indent = 0) const;
+    };
+
+} // namespace bench
+
+#endif // __BENCH_RB_TREE_CHUNKED_H__
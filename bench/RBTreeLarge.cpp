@@ -93,7 +93,7 @@ bool RBTreeLarge::lookup(int v) const
 {
     bool found = false;
 
-    BEGIN_TRANSACTION;
+    BEGIN_RO_TRANSACTION;
 
     found = false;
     // find v
@@ -40,14 +40,14 @@
 
 namespace bench
 {
-    class RBNodeLarge : public stm::Object<RBNodeLarge>
+    class RBNodeLarge : public stm::InPlaceObject<RBNodeLarge>
     {
-        GENERATE_FIELD(Color, color);
-        GENERATE_FIELD(int, val);
+        GENERATE_UNDO_FIELD(Color, color);
+        GENERATE_UNDO_FIELD(int, val);
         // invariant: parent->child[ID] == this
-        GENERATE_FIELD(stm::sh_ptr<RBNodeLarge>, parent);
-        GENERATE_FIELD(int, ID);
-        GENERATE_ARRAY(stm::sh_ptr<RBNodeLarge>, child, 2);
+        GENERATE_UNDO_FIELD(stm::sh_ptr<RBNodeLarge>, parent);
+        GENERATE_UNDO_FIELD(int, ID);
+        GENERATE_UNDO_ARRAY(stm::sh_ptr<RBNodeLarge>, child, 2);
       public:
         // add some padding to make copying expensive
         int pad[1024];
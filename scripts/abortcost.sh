@@ -0,0 +1,41 @@
+#!/bin/bash
+
+# Cost of an abort under each abort mechanism.  Build Bench once with
+# ABORT_MECHANISM=EXCEPTION and once with ABORT_MECHANISM=LONGJMP, copy each
+# executable aside, and pass both.  Every AbortCost transaction aborts 4
+# times before it commits, so the throughput ratio is mostly the ratio of
+# abort costs.  Usage:
+#   abortcost.sh exception_bench longjmp_bench [max threads] [extra args]
+
+if [ $# -lt 2 ]; then
+    echo "Usage: abortcost.sh exception_bench longjmp_bench [threads] [args]"
+    exit
+fi
+
+for prog in $1 $2
+do
+    if ! [ -f $prog ]; then
+        echo "File "$prog" not found"
+        exit
+    fi
+done
+
+maxthreads=${3:-8}
+duration=5
+
+echo "mechanism validation threads txns/sec"
+for v in "invis-eager" "vis-eager"
+do
+    threads=1
+    while [ $threads -le $maxthreads ]
+    do
+        for prog in $1 $2
+        do
+            mech=`$prog -h 2>&1 | grep "ABORT MECHANISM" | awk '{print $4}'`
+            tps=`$prog -B AbortCost -V $v -p $threads -d $duration $4 $5 \
+                 2>&1 | grep "txns per second" | head -1 | awk '{print $1}'`
+            echo "$mech $v $threads $tps"
+        done
+        threads=$((threads * 2))
+    done
+done
@@ -0,0 +1,45 @@
+#!/bin/bash
+
+# Cache misses per transaction at high thread counts, to check that the
+# descriptor layout keeps remote writes off the lines the owner uses, and
+# how much copying RBTreeChunked saves over RBTreeLarge.
+# Needs perf.  Usage:
+#   cachemisses.sh [rstm|redo_lock|cgl] [max threads] [extra Bench args]
+
+# set the benchmark exe name
+if [ -n $1"" ]; then
+    prog=./bench/obj/Bench_$1
+else
+    prog=./bench/obj/Bench_rstm
+fi
+
+# if the program does not exist, then exit
+if ! [ -f $prog ]; then
+    echo "File "$prog" not found"
+    exit
+fi
+
+maxthreads=${2:-16}
+duration=5
+events=cache-misses,cache-references,L1-dcache-load-misses
+
+echo "benchmark threads txns/sec cache-misses misses/txn l1-misses/txn"
+for bm in "Counter" "LinkedList" "RBTree" "RBTreeLarge" "RBTreeChunked"
+do
+    threads=1
+    while [ $threads -le $maxthreads ]
+    do
+        out=`perf stat -x, -e $events $prog -B $bm -V invis-eager \
+             -p $threads -d $duration $3 $4 2>&1`
+        tps=`echo "$out" | grep "txns per second" | head -1 | awk '{print $1}'`
+        misses=`echo "$out" | grep ",cache-misses" | cut -d, -f1`
+        l1=`echo "$out" | grep ",L1-dcache-load-misses" | cut -d, -f1`
+        txns=`echo "$out" | grep "Transactions:" | awk '{print $2}' | tr -d ,`
+        if [ -n "$txns" ] && [ "$txns" -gt 0 ]; then
+            echo "$bm $threads $tps $misses $((misses / txns)) $((l1 / txns))"
+        else
+            echo "$bm $threads $tps $misses - -"
+        fi
+        threads=$((threads * 2))
+    done
+done
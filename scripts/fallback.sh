@@ -0,0 +1,41 @@
+#!/bin/bash
+
+# Throughput of the livelock-prone benchmarks with the fallback lock off and
+# at several thresholds, and how often each run fell back.  Build with
+# COUNT_CONFLICTS=on to get the fallback counts.  Usage:
+#   fallback.sh [rstm] [max threads] [extra Bench args]
+
+# set the benchmark exe name
+if [ -n $1"" ]; then
+    prog=./bench/obj/Bench_$1
+else
+    prog=./bench/obj/Bench_rstm
+fi
+
+# if the program does not exist, then exit
+if ! [ -f $prog ]; then
+    echo "File "$prog" not found"
+    exit
+fi
+
+maxthreads=${2:-16}
+duration=5
+
+echo "benchmark threads threshold txns/sec fallbacks"
+for bm in "RandomGraph" "LFUCache"
+do
+    threads=1
+    while [ $threads -le $maxthreads ]
+    do
+        for f in 0 4 16 64
+        do
+            out=`$prog -B $bm -V invis-eager -p $threads -d $duration \
+                 -F $f $3 $4 2>&1`
+            tps=`echo "$out" | grep "txns per second" | head -1 | awk '{print $1}'`
+            fb=`echo "$out" | grep -o "Fallbacks = [0-9]*" \
+                | awk '{s += $3} END {print s + 0}'`
+            echo "$bm $threads $f $tps $fb"
+        done
+        threads=$((threads * 2))
+    done
+done
@@ -0,0 +1,59 @@
+#!/bin/bash
+
+# Per-object metadata versus redo_lock's global orec table.  Pass Bench_rstm
+# (header indirection), Bench_redo_lock built as usual (version and owner in
+# each object), and Bench_redo_lock built with OREC_TABLE=on, copied aside.
+# Reports throughput and, with perf, L1 misses per transaction, which is
+# where the two layouts differ.  Usage:
+#   orectable.sh rstm_bench redo_lock_bench orec_bench [max threads] [args]
+
+if [ $# -lt 3 ]; then
+    echo "Usage: orectable.sh rstm_bench redo_lock_bench orec_bench" \
+         "[threads] [args]"
+    exit
+fi
+
+for prog in $1 $2 $3
+do
+    if ! [ -f $prog ]; then
+        echo "File "$prog" not found"
+        exit
+    fi
+done
+
+maxthreads=${4:-8}
+duration=5
+
+echo "layout benchmark validation threads txns/sec l1-misses/txn"
+for bm in "LinkedList" "RBTree"
+do
+    for v in "invis-eager" "invis-lazy"
+    do
+        threads=1
+        while [ $threads -le $maxthreads ]
+        do
+            for prog in $1 $2 $3
+            do
+                about=`$prog -h 2>&1`
+                layout=`echo "$about" | grep "STM VERSION" | awk '{print $4}'`
+                orec=`echo "$about" | grep "OREC TABLE" | awk '{print $4}'`
+                if [ "$orec" = "on" ]; then
+                    layout=$layout"-orec"
+                fi
+                out=`perf stat -x, -e L1-dcache-load-misses $prog -B $bm \
+                     -V $v -p $threads -d $duration $5 $6 2>&1`
+                tps=`echo "$out" | grep "txns per second" | head -1 \
+                     | awk '{print $1}'`
+                l1=`echo "$out" | grep ",L1-dcache-load-misses" | cut -d, -f1`
+                txns=`echo "$out" | grep "Transactions:" | awk '{print $2}' \
+                      | tr -d ,`
+                if [ -n "$txns" ] && [ -n "$l1" ] && [ "$txns" -gt 0 ]; then
+                    echo "$layout $bm $v $threads $tps $((l1 / txns))"
+                else
+                    echo "$layout $bm $v $threads $tps -"
+                fi
+            done
+            threads=$((threads * 2))
+        done
+    done
+done
@@ -0,0 +1,35 @@
+#!/bin/bash
+
+# Throughput versus data structure size, for the benchmarks whose
+# transactions read many objects.  Usage:
+#   sweepsize.sh [rstm|redo_lock|cgl] [threads] [extra Bench args]
+
+# set the benchmark exe name
+if [ -n $1"" ]; then
+    prog=./bench/obj/Bench_$1
+else
+    prog=./bench/obj/Bench_rstm
+fi
+
+# if the program does not exist, then exit
+if ! [ -f $prog ]; then
+    echo "File "$prog" not found"
+    exit
+fi
+
+threads=${2:-4}
+duration=5
+
+echo "benchmark validation keys txns/sec"
+for bm in "LinkedList" "RBTreeLarge"
+do
+    for val in "invis-eager" "invis-lazy" "vis-eager"
+    do
+        for keys in 64 256 1024 4096 16384
+        do
+            tps=`$prog -B $bm -V $val -p $threads -d $duration -m $keys $3 $4 \
+                 | grep "txns per second" | head -1 | awk '{print $1}'`
+            echo "$bm $val $keys $tps"
+        done
+    done
+done
@@ -0,0 +1,209 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2005, 2006
+// University of Rochester
+// Department of Computer Science
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//    * Redistributions of source code must retain the above copyright notice,
+//      this list of conditions and the following disclaimer.
+//
+//    * Redistributions in binary form must reproduce the above copyright
+//      notice, this list of conditions and the following disclaimer in the
+//      documentation and/or other materials provided with the distribution.
+//
+//    * Neither the name of the University of Rochester nor the names of its
+//      contributors may be used to endorse or promote products derived from
+//      this software without specific prior written permission.
+//
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+
+#ifndef __BACKOFF_H__
+#define __BACKOFF_H__
+
+#include <string>
+#include <cstdlib>
+#include <limits>
+#include <sched.h>
+#include "stm_common.h"
+#include "atomic_ops.h"
+#include "hrtime.h"
+
+#ifdef LINUX
+#include <time.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+#endif
+
+namespace stm
+{
+    namespace cm
+    {
+        /**
+         *  How a contention manager waits when a transaction is in its way,
+         *  and how a thread waits before it retries an aborted transaction.
+         *  Each CM picks the strategy that suits it.  set_backoff_strategy()
+         *  (Bench -K) replaces that choice in every CM, and also makes
+         *  threads wait between attempts.
+         */
+        class BackoffPolicy
+        {
+          public:
+            enum Strategy {
+                CM_DEFAULT,   // no override: each CM uses its own strategy
+                NOPS,         // a fixed run of nops, the CMs' own default
+                TIMED,        // randomized exponential time window, Polite's
+                SPIN,         // a fixed run of pause instructions
+                EXPONENTIAL,  // randomized exponential run of pauses
+                YIELD,        // give the processor away with sched_yield()
+                PARK          // sleep on a futex until the enemy is done
+            };
+
+            /**
+             *  The strategy that replaces every CM's own; backed in
+             *  ContentionManager.cpp
+             */
+            static Strategy forced;
+
+            BackoffPolicy(Strategy own)
+                : own(own), seed((unsigned long)this), enemyState(NULL),
+                  enemyParked(NULL)
+            { }
+
+            /**
+             *  The next wait is on the transaction whose state is
+             *  /state/.  It wakes whoever /parked/ counts when it cleans
+             *  up.  NULL if there is no single enemy.
+             */
+            void setEnemy(volatile unsigned long* state,
+                          volatile unsigned long* parked)
+            {
+                enemyState = state;
+                enemyParked = parked;
+            }
+
+            /**
+             *  Wait for the /tries/th time in a row
+             */
+            void wait(unsigned long tries)
+            {
+                switch (forced == CM_DEFAULT ? own : forced) {
+                  case NOPS:
+                    for (unsigned long i = 0; i < INTERVAL; i++)
+                        nop();
+                    break;
+                  case TIMED: {
+                      if (tries > TIMED_MAX - TIMED_MIN)
+                          tries = TIMED_MAX - TIMED_MIN;
+                      // spin until a random delay within the window has
+                      // passed
+                      unsigned long long start = getElapsedTime();
+                      unsigned long delay =
+                          rand_r(&seed) % (1UL << (tries + TIMED_MIN));
+                      while (getElapsedTime() < start + delay)
+                          ;
+                      break;
+                  }
+                  case EXPONENTIAL: {
+                      if (tries > MAX_BACKOFF - MIN_BACKOFF)
+                          tries = MAX_BACKOFF - MIN_BACKOFF;
+                      // somewhere in the upper half of the window, so that
+                      // threads that collided once don't collide again
+                      unsigned long window = 1UL << (tries + MIN_BACKOFF);
+                      spin(window / 2 + rand_r(&seed) % (window / 2));
+                      break;
+                  }
+                  case YIELD:
+                    sched_yield();
+                    break;
+                  case PARK:
+                    park();
+                    break;
+                  default:
+                    spin(INTERVAL);
+                    break;
+                }
+                enemyState = NULL;
+                enemyParked = NULL;
+            }
+
+            /**
+             *  Wake everyone parked on /state/.  The owner of /state/ calls
+             *  this when it cleans up, if anyone is.
+             */
+            static void wake(volatile unsigned long* state)
+            {
+#ifdef LINUX
+                syscall(SYS_futex, state, FUTEX_WAKE,
+                        std::numeric_limits<int>::max(), NULL, NULL, 0);
+#endif
+            }
+
+          private:
+            enum Backoff {
+                INTERVAL = 1000,      // nops per NOPS, pauses per SPIN
+                TIMED_MIN = 7,        // TIMED: up to 2^(tries + MIN) ns,
+                TIMED_MAX = 29,       // at most 2^MAX
+                MIN_BACKOFF = 4,      // EXPONENTIAL: 2^MIN to 2^MAX pauses
+                MAX_BACKOFF = 16,
+                PARK_NS = 1000000     // longest sleep, in case of a lost wake
+            };
+
+            Strategy own;
+            unsigned int seed;
+            volatile unsigned long* enemyState;
+            volatile unsigned long* enemyParked;
+
+            static void spin(unsigned long pauses)
+            {
+                for (unsigned long i = 0; i < pauses; i++)
+                    spin_pause();
+            }
+
+            /**
+             *  Sleep until the enemy leaves ACTIVE.  We count ourselves in
+             *  its parked counter before we look at its state, and it sets
+             *  its state before it looks at the counter, so one of us sees
+             *  the other.  The timeout covers an enemy that is ACTIVE again
+             *  in its next transaction by the time we sleep.  Without an
+             *  enemy, or off Linux, this is a yield.
+             */
+            void park()
+            {
+#ifdef LINUX
+                if (enemyState) {
+                    fai(enemyParked);
+                    if (*enemyState == ACTIVE) {
+                        struct timespec timeout = { 0, PARK_NS };
+                        // the futex word is the low half of the state on a
+                        // little-endian 64-bit host
+                        syscall(SYS_futex, enemyState, FUTEX_WAIT, ACTIVE,
+                                &timeout, NULL, 0);
+                    }
+                    fad(enemyParked);
+                    return;
+                }
+#endif
+                sched_yield();
+            }
+        };
+    } // namespace stm::cm
+} // namespace stm
+
+#endif // __BACKOFF_H__
@@ -14,7 +14,8 @@ namespace stm {
 		class BiModalCM : public ContentionManager
 		{
 			private:
-				// the id of the core where the transaction is excecuted
+				// the scheduler that runs the transaction, and the id of its core there
+				stm::scheduler::BiModalScheduler* m_scheduler;
 				int m_iCore;
 				int m_epoch;
 				
@@ -23,16 +24,24 @@ namespace stm {
 				
 				bool m_newTx;
 				
-				time_t getTimestamp() { return stm::scheduler::BiModalScheduler::instance()->getTxTimestamp(m_iCore); }
-				void setTimestamp(time_t stamp) { stm::scheduler::BiModalScheduler::instance()->setTxTimestamp(m_iCore, stamp); }
-				bool isReadOnly() { return stm::scheduler::BiModalScheduler::instance()->isTxRO(m_iCore); }
-				void setReadOnly(bool value) { stm::scheduler::BiModalScheduler::instance()->setTxRO(m_iCore, value); }
+				time_t getTimestamp() { return m_scheduler->getTxTimestamp(m_iCore); }
+				void setTimestamp(time_t stamp) { m_scheduler->setTxTimestamp(m_iCore, stamp); }
+				bool isReadOnly() { return m_scheduler->isTxRO(m_iCore); }
+				void setReadOnly(bool value) { m_scheduler->setTxRO(m_iCore, value); }
 				long getEpoch() {return m_epoch;}
 				
 			public:
 				
-				BiModalCM() : m_iCore(sched_getcpu()), 
-							  m_reschedule(false), m_newTx(true) {}
+				static const CMKind KIND = CM_BIMODAL;
+				
+				BiModalCM() : m_scheduler(NULL), m_iCore(sched_getcpu()), 
+							  m_reschedule(false), m_newTx(true) { kind = KIND; }
+				
+				virtual void onScheduled(stm::scheduler::BiModalScheduler* sched, int iCore)
+				{
+					m_scheduler = sched;
+					m_iCore = iCore;
+				}
 				
 				~BiModalCM(){}
 				
@@ -56,14 +65,24 @@ namespace stm {
 							setTimestamp(t.tv_sec);
 						}
 					}
-					m_epoch = stm::scheduler::BiModalScheduler::instance()->getCurrentEpoch(m_iCore);
+					m_epoch = m_scheduler->getCurrentEpoch(m_iCore);
 				}
 				
 				bool ShouldAbort(ContentionManager *enemy) 
 				{
-					stm::scheduler::BiModalScheduler::instance()->increaseConflictCounter();
+					m_scheduler->increaseConflictCounter();
 					std::cout << "conflict\n";
-					BiModalCM* b = dynamic_cast<BiModalCM*>(enemy);
+					BiModalCM* b = same<BiModalCM>(enemy);
+					
+					/*
+					 * Epochs and cores of another scheduler instance mean nothing
+					 * to us, so neither side is rescheduled and the older wins
+					 */
+					if (b->m_scheduler != m_scheduler) {
+						m_reschedule = false;
+						b->m_reschedule = false;
+						return (b->getTimestamp() < getTimestamp());
+					}
 
 					/*
 					 * If two transactions with different epoch ids have a conflict
@@ -88,7 +107,7 @@ namespace stm {
 					m_reschedule = true;
 					b->m_reschedule = true;
 					if (IS_READING(getEpoch()))
-						stm::scheduler::BiModalScheduler::instance()->increaseFalsePositiveCounter();
+						m_scheduler->increaseFalsePositiveCounter();
 					/*
 					 * If two writing transactions have a conflict, the transaction
 					 * with the bigger (i.e. younger) timestamp is aborted
@@ -121,9 +140,9 @@ namespace stm {
 					if (m_reschedule) {
 						std::cout << "onConflictWith\n";
 						if (isReadOnly())
-							stm::scheduler::BiModalScheduler::instance()->moveJobToROQueue(m_iCore);
+							m_scheduler->moveJobToROQueue(m_iCore);
 						else
-							stm::scheduler::BiModalScheduler::instance()->reschedule(m_iCore,iCore);
+							m_scheduler->reschedule(m_iCore,iCore);
 					}
 				}
 				
@@ -35,6 +35,7 @@
 #include <iostream>
 
 #include "ContentionManager.h"
+#include "ReaderIndicator.h"
 
 #ifdef RSTM
 #include "Descriptor_rstm.h"
@@ -92,28 +93,46 @@ stm::cm::ContentionManager* stm::cm::Factory(std::string cm_type)
     }
 }
 
+// by default each CM backs off its own way
+stm::cm::BackoffPolicy::Strategy stm::cm::BackoffPolicy::forced =
+    stm::cm::BackoffPolicy::CM_DEFAULT;
+
+bool stm::set_backoff_strategy(std::string strategy)
+{
+    using stm::cm::BackoffPolicy;
+    if (strategy == "")
+        BackoffPolicy::forced = BackoffPolicy::CM_DEFAULT;
+    else if (strategy == "spin")
+        BackoffPolicy::forced = BackoffPolicy::SPIN;
+    else if (strategy == "exponential")
+        BackoffPolicy::forced = BackoffPolicy::EXPONENTIAL;
+    else if (strategy == "yield")
+        BackoffPolicy::forced = BackoffPolicy::YIELD;
+    else if (strategy == "park")
+        BackoffPolicy::forced = BackoffPolicy::PARK;
+    else
+        return false;
+    return true;
+}
+
 // provide backing for the Greedy and Serializer timeCounter variables
 volatile unsigned long stm::cm::Greedy::timeCounter = 0;
 volatile unsigned long stm::cm::Serializer::timeCounter = 0;
 
 // for polkavis, writers get permission to abort vis readers
-bool stm::cm::PolkaVis::ShouldAbortAll(unsigned long bitmap)
+bool stm::cm::PolkaVis::ShouldAbortAll(
+    const stm::internal::ReaderIndicator& readers)
 {
-    unsigned int index = 0;
-    unsigned int bits = bitmap;
+    unsigned long index;
+    stm::internal::ReaderIndicator::iterator it(readers);
 
-    while (bits) {
-        if (bits & 1) {
-            stm::internal::Descriptor* reader =
-                stm::internal::desc_array[index];
+    while (it.next(index)) {
+        stm::internal::Descriptor* reader = stm::internal::desc_array[index];
 
-            if (reader->cm.getCM() != this)
-                // if can't abort this reader, return false
-                if (!Polka::ShouldAbort(reader->cm.getCM()))
-                    return false;
-        }
-        bits >>= 1;
-        index++;
+        if (reader->cm.getCM() != this)
+            // if can't abort this reader, return false
+            if (!Polka::ShouldAbort(reader->cm.getCM()))
+                return false;
     }
     return true;
 }
@@ -40,6 +40,7 @@
 #include <sys/time.h>
 #include "atomic_ops.h"
 #include "hrtime.h"
+#include "Backoff.h"
 
 #ifndef USE_BIMODAL
 #define USE_BIMODAL
@@ -47,15 +48,79 @@
 
 namespace stm
 {
+#ifdef USE_BIMODAL
+    namespace scheduler
+    {
+        class BiModalScheduler;
+    }
+#endif
+
+    namespace internal
+    {
+        class ReaderIndicator;
+    }
+
     namespace cm
     {
+        /**
+         *  The concrete class of a ContentionManager.  It lets a CM cast its
+         *  enemy without RTTI, and HybridCMPolicy bind calls to the CM
+         *  picked at run time without going through the vtable.
+         */
+        enum CMKind {
+            CM_UNKNOWN,     CM_AGGRESSIVE,  CM_POLITE,      CM_KARMA,
+            CM_POLKA,       CM_GREEDY,      CM_SERIALIZER,  CM_KILLBLOCKED,
+            CM_ERUPTION,    CM_TIMESTAMP,   CM_WHPOLKA,     CM_POLKAVIS,
+            CM_POLKARUPTION, CM_JUSTICE,    CM_HIGHLANDER,  CM_BIMODAL
+        };
+
         class ContentionManager
         {
           protected:
             int priority;
+
+            // set by the constructor of the most derived class
+            CMKind kind;
+
+            // how this CM waits; CMs that don't wait leave it at NOPS
+            BackoffPolicy delay;
+
+            ContentionManager(BackoffPolicy::Strategy backoff)
+                : priority(0), kind(CM_UNKNOWN), delay(backoff)
+            { }
+
+            // /enemy/ as a T, or NULL if it is some other kind of CM
+            template <class T>
+            static T* same(ContentionManager* enemy)
+            {
+                return (enemy && enemy->kind == T::KIND)
+                    ? static_cast<T*>(enemy) : NULL;
+            }
+
           public:
-            ContentionManager() : priority(0) { }
+            ContentionManager()
+                : priority(0), kind(CM_UNKNOWN), delay(BackoffPolicy::NOPS)
+            { }
             int getPriority() { return priority; }
+            CMKind getKind() const { return kind; }
+
+            // the transaction in the way of the next onContention(), if any
+            void setEnemy(volatile unsigned long* state,
+                          volatile unsigned long* parked)
+            {
+                delay.setEnemy(state, parked);
+            }
+
+            // wait before retrying a transaction that aborted /aborts/ times
+            // in a row.  Only if a strategy was forced on every CM: by
+            // default, retries start right away.
+            void beforeRetry(unsigned long aborts)
+            {
+                if (BackoffPolicy::forced != BackoffPolicy::CM_DEFAULT) {
+                    delay.setEnemy(NULL, NULL);
+                    delay.wait(aborts);
+                }
+            }
 
             // Transaction-level events
             virtual void OnBeginTransaction() { }
@@ -65,6 +130,8 @@ namespace stm
 
 #ifdef USE_BIMODAL
 			virtual void onConflictWith(int iCore) {}
+			// the thread now runs the jobs of iCore in the given scheduler
+			virtual void onScheduled(scheduler::BiModalScheduler* sched, int iCore) {}
 #endif
 
             // Object-level events
@@ -73,21 +140,13 @@ namespace stm
             virtual void OnOpenWrite() { }
             virtual void OnReOpen() { }
             virtual bool ShouldAbort(ContentionManager* enemy) = 0;
-            virtual bool ShouldAbortAll(unsigned long bitmap) { return true; }
+            virtual bool ShouldAbortAll(const internal::ReaderIndicator& readers) { return true; }
             virtual ~ContentionManager() { }
         };
 
         // create a contention manager
         ContentionManager* Factory(std::string cm_type);
 
-        // wait by executing a bunch of nops in a loop (not preemption
-        // tolerant)
-        inline void nano_sleep(unsigned long nops)
-        {
-            for (unsigned long i = 0; i < nops; i++)
-                nop();
-        }
-
         ///////////////////////////////////////////////////////
         //
         // CM Implementations
@@ -97,7 +156,9 @@ namespace stm
         {
           public:
             // ctor only needs what is provided by ContentionManager
-            Aggressive() { }
+            static const CMKind KIND = CM_AGGRESSIVE;
+
+            Aggressive() { kind = KIND; }
 
             virtual bool ShouldAbort(ContentionManager* enemy)
             {
@@ -111,37 +172,16 @@ namespace stm
             // randomized exponential backoff interface; shared with all
             // descendants
           protected:
-            enum Backoff {
-                MIN_BACKOFF = 7,
-                MAX_BACKOFF = 28,
-                MAX_BACKOFF_RETRIES = MAX_BACKOFF - MIN_BACKOFF + 1
-            };
+            enum Backoff { MAX_BACKOFF_RETRIES = 22 };
 
             // how many times have we backed off without opening anything
             int tries;
 
-            // seed for randomized exponential backoff
-            unsigned int seed;
-
             // randomized exponential backoff
             void backoff()
             {
-                if (tries > 0 && tries <= MAX_BACKOFF_RETRIES) {
-                    // what time is it now
-                    unsigned long long starttime = getElapsedTime();
-
-                    // how long should we wait (random)
-                    unsigned long delay = rand_r(&seed);
-                    delay = delay % (1 << (tries + MIN_BACKOFF));
-
-                    // spin until /delay/ nanoseconds have passed.  We can do
-                    // whatever we want in the spin, as long as it doesn't have
-                    // an impact on other threads
-                    unsigned long long endtime;
-                    do {
-                        endtime = getElapsedTime();
-                    } while (endtime < starttime + delay);
-                }
+                if (tries > 0 && tries <= MAX_BACKOFF_RETRIES)
+                    delay.wait(tries);
                 tries++;
             }
 
@@ -150,7 +190,13 @@ namespace stm
             void OnOpen() { tries = 0; }
 
           public:
-            Polite() : tries(0), seed(0) { }
+            static const CMKind KIND = CM_POLITE;
+
+            Polite()
+                : ContentionManager(BackoffPolicy::TIMED), tries(0)
+            {
+                kind = KIND;
+            }
 
             // request permission to abort enemy tx
             virtual bool ShouldAbort(ContentionManager* enemy)
@@ -171,8 +217,6 @@ namespace stm
         class Karma: public ContentionManager
         {
           private:
-            enum Backoff { INTERVAL = 1000 };
-
             int tries;
 
             // every time we Try to Open something, backoff once more and
@@ -180,7 +224,7 @@ namespace stm
             void OnTryOpen(void)
             {
                 if (tries > 1)
-                    nano_sleep(INTERVAL);
+                    delay.wait(tries);
 
                 tries++;
             }
@@ -195,7 +239,9 @@ namespace stm
 
           public:
             // constructor
-            Karma() : tries(1) { }
+            static const CMKind KIND = CM_KARMA;
+
+            Karma() : tries(1) { kind = KIND; }
 
             // request permission to abort enemies
             virtual bool ShouldAbort(ContentionManager* enemy)
@@ -228,7 +274,9 @@ namespace stm
           public:
             // everything in the Polka ctor is handled by Polite() and
             // ContentionManager()
-            Polka() { }
+            static const CMKind KIND = CM_POLKA;
+
+            Polka() { kind = KIND; }
 
             // query the enemy cm to get its priority, return true if enemy's
             // priority is lower than mine.
@@ -256,7 +304,13 @@ namespace stm
             static volatile unsigned long timeCounter;
 
           public:
-            Greedy() : waiting(false) { timestamp = fai(&timeCounter); }
+            static const CMKind KIND = CM_GREEDY;
+
+            Greedy() : waiting(false)
+            {
+                kind = KIND;
+                timestamp = fai(&timeCounter);
+            }
 
             virtual void OnBeginTransaction() { waiting = false; }
 
@@ -268,7 +322,7 @@ namespace stm
 
             virtual bool ShouldAbort(ContentionManager* enemy)
             {
-                Greedy* B = dynamic_cast<Greedy*>(enemy);
+                Greedy* B = same<Greedy>(enemy);
 
                 if ((timestamp < B->timestamp) || (B->waiting == true)) {
                     // I abort B
@@ -296,7 +350,9 @@ namespace stm
             static volatile unsigned long timeCounter;
 
           public:
-            Serializer() { }
+            static const CMKind KIND = CM_SERIALIZER;
+
+            Serializer() { kind = KIND; }
             virtual void OnBeginTransaction()
             {
                 timestamp = fai(&timeCounter);
@@ -304,7 +360,7 @@ namespace stm
 
             virtual bool ShouldAbort(ContentionManager* enemy)
             {
-                Serializer* B = dynamic_cast<Serializer*>(enemy);
+                Serializer* B = same<Serializer>(enemy);
                 if ((timestamp < B->timestamp))
                     // I abort B
                     return true;
@@ -317,7 +373,7 @@ namespace stm
         class Killblocked: public ContentionManager
         {
           private:
-            enum Backoff { INTERVAL = 1000, MAX_TRIES = 16 };
+            enum Backoff { MAX_TRIES = 16 };
 
             int tries;
             bool blocked;
@@ -330,14 +386,16 @@ namespace stm
             }
 
           public:
-            Killblocked() : tries(0), blocked(false) { }
+            static const CMKind KIND = CM_KILLBLOCKED;
+
+            Killblocked() : tries(0), blocked(false) { kind = KIND; }
 
             bool IsBlocked(void) { return blocked; }
 
             // request permission to abort enemy tx
             virtual bool ShouldAbort(ContentionManager* enemy)
             {
-                Killblocked* k = dynamic_cast<Killblocked*>(enemy);
+                Killblocked* k = same<Killblocked>(enemy);
 
                 if (tries > MAX_TRIES)
                     return true;
@@ -351,7 +409,7 @@ namespace stm
             virtual void onContention()
             {
                 blocked = true;
-                nano_sleep(INTERVAL);
+                delay.wait(tries);
                 tries++;
             }
 
@@ -365,15 +423,13 @@ namespace stm
         class Eruption: public ContentionManager
         {
           private:
-            enum Backoff { INTERVAL = 1000 };
-
             int tries;
             int prio_transferred;
 
             void OnTryOpen(void)
             {
                 if (tries > 1)
-                    nano_sleep(INTERVAL);
+                    delay.wait(tries);
 
                 tries++;
             }
@@ -386,7 +442,9 @@ namespace stm
             }
 
           public:
-            Eruption() : tries(1), prio_transferred(0) { }
+            static const CMKind KIND = CM_ERUPTION;
+
+            Eruption() : tries(1), prio_transferred(0) { kind = KIND; }
 
             virtual bool ShouldAbort(ContentionManager* enemy)
             {
@@ -399,7 +457,7 @@ namespace stm
                     return true;
                 }
                 else {
-                    e = dynamic_cast<Eruption*>(enemy);
+                    e = same<Eruption>(enemy);
 
                     if (e) {
                         e->givePrio(priority - prio_transferred);
@@ -431,7 +489,7 @@ namespace stm
         class Timestamp: public ContentionManager
         {
           private:
-            enum Backoff { INTERVAL = 1000, MAX_TRIES = 8 };
+            enum Backoff { MAX_TRIES = 8 };
 
             int tries;
             int max_tries;
@@ -446,11 +504,16 @@ namespace stm
             }
 
           public:
-            Timestamp() : tries(0), max_tries(MAX_TRIES), defunct(false) { }
+            static const CMKind KIND = CM_TIMESTAMP;
+
+            Timestamp() : tries(0), max_tries(MAX_TRIES), defunct(false)
+            {
+                kind = KIND;
+            }
 
             virtual bool ShouldAbort(ContentionManager* enemy)
             {
-                Timestamp* t = dynamic_cast<Timestamp*>(enemy);
+                Timestamp* t = same<Timestamp>(enemy);
 
                 defunct = false;
 
@@ -488,7 +551,7 @@ namespace stm
             virtual void onContention()
             {
                 defunct = false;
-                nano_sleep(INTERVAL);
+                delay.wait(tries);
                 tries++;
             }
 
@@ -515,7 +578,9 @@ namespace stm
             enum Weights { READ_WEIGHT = 0, WRITE_WEIGHT = 1 };
 
           public:
-            Whpolka() { }
+            static const CMKind KIND = CM_WHPOLKA;
+
+            Whpolka() { kind = KIND; }
 
             // event methods
             virtual void OnOpenRead()
@@ -537,10 +602,12 @@ namespace stm
         {
           public:
             // simple constructor
-            PolkaVis() { }
+            static const CMKind KIND = CM_POLKAVIS;
+
+            PolkaVis() { kind = KIND; }
 
             // for polkavis, writers get permission to abort vis readers
-            virtual bool ShouldAbortAll(unsigned long bitmap);
+            virtual bool ShouldAbortAll(const internal::ReaderIndicator& readers);
         };
 
 
@@ -562,7 +629,9 @@ namespace stm
 
           public:
             // simple constructor
-            Polkaruption() : prio_transferred(0) { }
+            static const CMKind KIND = CM_POLKARUPTION;
+
+            Polkaruption() : prio_transferred(0) { kind = KIND; }
 
             // request permission to abort enemy tx
             virtual bool ShouldAbort(ContentionManager* enemy)
@@ -576,7 +645,7 @@ namespace stm
                     return true;
                 }
                 else {
-                    p = dynamic_cast<Polkaruption*>(enemy);
+                    p = same<Polkaruption>(enemy);
 
                     if (p) {
                         p->givePrio(priority - prio_transferred);
@@ -621,13 +690,15 @@ namespace stm
           public:
             // everything in the Justice ctor is handled by Polite() and
             // ContentionManager()
-            Justice() : reads(0), writes(0) { }
+            static const CMKind KIND = CM_JUSTICE;
+
+            Justice() : reads(0), writes(0) { kind = KIND; }
 
             // query the enemy cm to get its priority, return true if enemy's
             // priority is lower than mine.
             virtual bool ShouldAbort(ContentionManager* enemy)
             {
-                Justice* e = dynamic_cast<Justice*>(enemy);
+                Justice* e = same<Justice>(enemy);
                 return jprio() > e->jprio();
             }
 
@@ -656,7 +727,9 @@ namespace stm
         class Highlander: public Polka
         {
           public:
-            Highlander() { }
+            static const CMKind KIND = CM_HIGHLANDER;
+
+            Highlander() { kind = KIND; }
 
             virtual bool ShouldAbort(ContentionManager* enemy)
             {
@@ -672,6 +745,18 @@ namespace stm
             }
         };
 
+/**
+ *  Every CM that cm::Factory can build, as X(class, ARG).  Lets a policy
+ *  expand one case per CM so that each case makes direct, inlinable calls
+ *  on the concrete class.  BiModalCM is left out: it lives in its own
+ *  header and is always reached through the vtable.
+ */
+#define RSTM_CM_LIST(X, ARG)                                            \
+        X(Aggressive, ARG)  X(Polite, ARG)       X(Karma, ARG)           \
+        X(Polka, ARG)       X(Greedy, ARG)       X(Serializer, ARG)      \
+        X(Killblocked, ARG) X(Eruption, ARG)     X(Timestamp, ARG)       \
+        X(Whpolka, ARG)     X(PolkaVis, ARG)     X(Polkaruption, ARG)    \
+        X(Justice, ARG)     X(Highlander, ARG)
 
     } // namespace stm::cm
 } // namespace stm
@@ -37,6 +37,8 @@
 
 // standard requirements for all TMs
 #include <string>
+#include <cstdlib>
+#include <new>
 #include "stm_common.h"
 #include "MiniVector.h"
 
@@ -105,6 +107,21 @@ namespace stm
                 : shared(_sh), version(_ver) { }
         };
 
+#ifdef OREC_TABLE
+        /**
+         *  Tuple for storing all the info we need about an orec we own
+         */
+        struct orec_bookkeep_t
+        {
+            volatile unsigned long* orec;
+            unsigned long           version;
+
+            orec_bookkeep_t(volatile unsigned long* _orec = NULL,
+                            unsigned long _ver = 0)
+                : orec(_orec), version(_ver) { }
+        };
+#endif
+
         // forward declare the validator, since it and Descriptor are mutually
         // dependent
         class Validator;
@@ -120,9 +137,9 @@ namespace stm
          *  squash the many levels, but we don't want to have to maintain them,
          *  so we should clean them up.
          *
-         *  [todo] - review the placement of fields.  Some fields are accessed
-         *  by other threads, some aren't.  We should segregate fields into
-         *  different cache lines accordingly.
+         *  Fields are grouped by who touches them: tx_state and parked are
+         *  written by other transactions and get a line of their own, id and
+         *  cm are only read by them, and everything from timing on is private.
          */
         class Descriptor
         {
@@ -130,14 +147,32 @@ namespace stm
             /**
              * state is COMMITTED, ABORTED, or ACTIVE
              */
-            volatile unsigned long tx_state; // definitely read by other
-                                             // transactions
+            volatile unsigned long tx_state // definitely written by other
+            __attribute__ ((aligned(64)));  // transactions
+
+            /**
+             *  Number of threads parked until this transaction is done; see
+             *  cm::BackoffPolicy
+             */
+            volatile unsigned long parked;  // written by other transactions
 
             /**
              *  thread id
              */
-            const unsigned long id;     // definitely read by other
-                                        // transactions
+            const unsigned long id      // definitely read by other
+            __attribute__ ((aligned(64)));  // transactions
+
+            /**
+             *  Policy wrapper around a CM
+             */
+            HybridCMPolicy cm;  // definitely read by other transactions
+
+            /**
+             *  If we've turned on profiling instrumentation, this field is
+             *  where we'll store intermediate timing information.  It starts
+             *  the private part of the descriptor.
+             */
+            TimeAccounting timing __attribute__ ((aligned(64)));
 
 #ifdef PRIVATIZATION_NOFENCE
             /**
@@ -148,9 +183,17 @@ namespace stm
 #endif
 
             /**
-             *  Policy wrapper around a CM
+             *  new has to honor the alignment of the fields above
              */
-            HybridCMPolicy cm;  // definitely read by other transactions
+            static void* operator new(size_t size)
+            {
+                void* mem;
+                if (posix_memalign(&mem, 64, size) != 0)
+                    throw std::bad_alloc();
+                return mem;
+            }
+
+            static void operator delete(void* mem) { free(mem); }
 
             /**
              *  For privatization: check pcount and see if validation is
@@ -211,18 +254,32 @@ namespace stm
                 assert(!nontransactional());
             }
 
-            /**
-             *  If we've turned on profiling instrumentation, this field is
-             *  where we'll store intermediate timing information.
-             */
-            TimeAccounting timing;
-
             /**
              *  flag indicating if the current transaction is using lazy or
              *  eager acquire.
              */
             bool isLazy;
 
+            /**
+             *  0 outside a transaction, 1 in a top-level one.  Nested
+             *  transactions are flattened into the top level: they only
+             *  count here, and any abort aborts the whole transaction.
+             */
+            unsigned long nestDepth;
+
+            /**
+             *  true if the top-level transaction began with
+             *  BEGIN_RO_TRANSACTION: no allocation logging, no write set and
+             *  no CAS to commit
+             */
+            bool readOnly;
+
+            /**
+             *  How many times in a row this transaction aborted; see
+             *  cm::BackoffPolicy
+             */
+            unsigned long consecutiveAborts;
+
             /**
              *  Interface to thread-local allocator that manages reclamation on
              *  abort / commit automatically.
@@ -230,9 +287,10 @@ namespace stm
             DeferredReclamationMMPolicy mm;
 
             /**
-             *  Set all metadata up for a new transaction, and move to ACTIVE
+             *  Set all metadata up for a new transaction, and move to ACTIVE.
+             *  If /readOnly/, it promises never to open anything for writing.
              */
-            void beginTransaction();
+            void beginTransaction(bool readOnly = false);
 
             /**
              *  Attempt to commit a transaction
@@ -246,6 +304,21 @@ namespace stm
              */
             void abort(bool shouldThrow = true);
 
+#ifdef ABORT_LONGJMP
+            /**
+             *  The checkpoint of the innermost BEGIN_TRANSACTION.  With
+             *  ABORT_MECHANISM=LONGJMP, an abort jumps back to it instead of
+             *  throwing Aborted.  NULL outside a transaction.
+             */
+            jmp_buf* checkpoint;
+#endif
+
+            /**
+             *  Leave the transaction body for its END_TRANSACTION, by
+             *  throwing Aborted or by jumping to the checkpoint
+             */
+            void unwind() __attribute__((noreturn));
+
             /**
              *  Clean up after a transaction, return true if the tx is
              *  COMMITTED.  This cleans up all the metadata within the
@@ -362,6 +435,39 @@ namespace stm
              */
             MiniVector<lazy_bookkeep_t> lazyWrites;
 
+#ifdef OREC_TABLE
+            /**
+             *  The orecs we own, with the version each had when we got it
+             */
+            MiniVector<orec_bookkeep_t> heldOrecs;
+
+            /**
+             *  If we own /orec/, put the version it had when we acquired it
+             *  in /ver/ and return true.
+             */
+            bool heldVersion(volatile unsigned long* orec,
+                             unsigned long& ver) const;
+
+            /**
+             *  Lookup an entry in the eager write set.  Owning the orec of an
+             *  object doesn't tell us if we wrote it or another object that
+             *  hashes to the same orec.
+             */
+            SharedBase* lookupEagerWrite(SharedBase* shared);
+
+            /**
+             *  Read the orec of /obj/ until it holds a version or belongs to
+             *  us, going through the CM while anyone else owns it.
+             */
+            unsigned long readOrec(SharedBase* obj);
+
+            /**
+             *  Once the redo logs are written back (or discarded), give up
+             *  every orec we own.
+             */
+            void releaseOrecs(unsigned long tx_state);
+#endif
+
           public:
             /**
              *  MM wrapper for scheduling an object to be deleted if the
@@ -403,6 +509,7 @@ namespace stm
             bool acquire(SharedBase* obj, unsigned long exp_ver,
                          SharedBase* new_log);
 
+#ifndef OREC_TABLE
             /**
              *  Clean up an object's metadata when its owner transaction
              *  committed.  This entails trying to lock the object and apply
@@ -417,6 +524,7 @@ namespace stm
              */
             static bool cleanOnAbort(SharedBase* obj, Descriptor* exp_owner,
                                      SharedBase* exp_log);
+#endif
 
             /**
              *  Get a readable version of an object
@@ -463,9 +571,14 @@ namespace stm
 
             void validate(const SharedBase* sh) const
             {
+#ifdef OREC_TABLE
+                if (m_cachedVersion != 0 && *orec_of(sh) != m_cachedVersion)
+                    tx->abort();
+#else
                 if (m_cachedVersion != 0 &&
                     sh->m_metadata.fields.ver.version != m_cachedVersion)
                     tx->abort();
+#endif
 #ifndef PRIVATIZATION_BARRIER
                 tx->check_pcount();
 #endif
@@ -507,18 +620,43 @@ namespace stm
         internal::get_descriptor()->mm.txFree(ptr);
     }
 
+    /**
+     *  Abort the running transaction and start it over
+     */
+    inline void restart()
+    {
+        internal::get_descriptor()->abort();
+    }
+
     namespace internal
     {
-        inline void Descriptor::abort(bool shouldAbort)
+        inline void Descriptor::abort(bool shouldThrow)
         {
             timing.UPDATE_TIMING(TIMING_BOOKKEEPING);
+
+            // an exception leaving a flattened level just passes through
+            // it; the outermost level it leaves aborts the transaction
+            if (nestDepth > 1 && !shouldThrow && tx_state == ACTIVE)
+                return;
+
             tx_state = ABORTED;
 
             // Contention Manager notification
             cm.onTxAborted();
 
-            if (shouldAbort)
-                throw Aborted();
+            if (shouldThrow)
+                unwind();
+        }
+
+        inline void Descriptor::unwind()
+        {
+#ifdef ABORT_LONGJMP
+            // _longjmp leaves the signal mask alone, so this is a handful of
+            // register loads instead of a walk of the unwind tables
+            _longjmp(*checkpoint, 1);
+#else
+            throw Aborted();
+#endif
         }
 
         inline void Descriptor::validate()
@@ -548,12 +686,18 @@ namespace stm
                 abort();
         }
 
-        inline void Descriptor::beginTransaction()
+        inline void Descriptor::beginTransaction(bool readOnly)
         {
+            if (nestDepth++) {
+                verifySelf();
+                return;
+            }
+            this->readOnly = readOnly;
+
             timing.UPDATE_TIMING(TIMING_BOOKKEEPING);
 
             conflicts.onTxBegin();
-            mm.onTxBegin();
+            mm.onTxBegin(!readOnly);
 
             // mark myself active
             tx_state = stm::ACTIVE;
@@ -589,6 +733,76 @@ namespace stm
             return NULL;
         }
 
+#ifdef OREC_TABLE
+        inline SharedBase* Descriptor::lookupEagerWrite(SharedBase* shared)
+        {
+            if (eagerWrites.is_empty())
+                return NULL;
+
+            assert(shared);
+            eager_bookkeep_t* e = eagerWrites.elements;
+
+            for (unsigned long i = 0; i < eagerWrites.element_count; i++)
+                if (e[i].shared == shared)
+                    return e[i].redo_log;
+            return NULL;
+        }
+
+        inline bool Descriptor::heldVersion(volatile unsigned long* orec,
+                                            unsigned long& ver) const
+        {
+            orec_bookkeep_t* e = heldOrecs.elements;
+
+            for (unsigned long i = 0; i < heldOrecs.element_count; i++) {
+                if (e[i].orec == orec) {
+                    ver = e[i].version;
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        inline unsigned long Descriptor::readOrec(SharedBase* obj)
+        {
+            volatile unsigned long* orec = orec_of(obj);
+
+            while (true) {
+                unsigned long o = *orec;
+                if ((o & 1) || o == reinterpret_cast<unsigned long>(this))
+                    return o;
+
+                // someone else owns the orec.  Only the owner can write back
+                // its redo logs and release it, so even once we abort it we
+                // have to wait.
+                Descriptor* owner = reinterpret_cast<Descriptor*>(o);
+                if (owner->tx_state == ACTIVE
+                    && cm.shouldAbort(owner->cm.getCM()))
+                    bool_cas(&(owner->tx_state), ACTIVE, ABORTED);
+
+                timing.UPDATE_TIMING(TIMING_CM);
+                cm.onContention(&owner->tx_state, &owner->parked);
+                verifySelf();
+                timing.UPDATE_TIMING(TIMING_BOOKKEEPING);
+            }
+        }
+
+        inline void Descriptor::releaseOrecs(unsigned long tx_state)
+        {
+            if (heldOrecs.is_empty())
+                return;
+
+            // the writeback must be visible before any orec is
+            cfence();
+
+            orec_bookkeep_t* e = heldOrecs.elements;
+
+            for (unsigned long i = 0; i < heldOrecs.element_count; i++)
+                *e[i].orec = (tx_state == stm::COMMITTED)
+                    ? e[i].version + 2 : e[i].version;
+            heldOrecs.reset();
+        }
+#endif
+
 
         inline void Descriptor::check_pcount()
         {
@@ -616,9 +830,19 @@ namespace stm
             invisibleReads(mm.getHeap(), 64),
             eagerWrites(mm.getHeap(), 64),
             lazyWrites(mm.getHeap(), 64)
+#ifdef OREC_TABLE
+            , heldOrecs(mm.getHeap(), 64)
+#endif
         {
             // the state is COMMITTED, in tx #0
             tx_state = stm::COMMITTED;
+            nestDepth = 0;
+            readOnly = false;
+            parked = 0;
+            consecutiveAborts = 0;
+#ifdef ABORT_LONGJMP
+            checkpoint = NULL;
+#endif
 
 #ifdef PRIVATIZATION_NOFENCE
             pcount_cache = pcount;
@@ -636,6 +860,17 @@ namespace stm
 
         inline bool Descriptor::cleanup()
         {
+            // a flattened level commits with its parent, and its abort is
+            // its parent's.  An exception leaving it is still ACTIVE here,
+            // and END_TRANSACTION rethrows it.
+            if (nestDepth > 1) {
+                nestDepth--;
+                if (tx_state == stm::ABORTED)
+                    unwind();
+                return true;
+            }
+            nestDepth = 0;
+
             timing.UPDATE_TIMING(TIMING_BOOKKEEPING);
 
             // invariant: status == COMMITTED or ABORTED
@@ -650,15 +885,31 @@ namespace stm
 
             // at the end of a transaction, we are supposed to restore the
             // headers of any objects that we acquired (regardless of whether
-            // the tx aborted or committed), and to apply redo logs
-            cleanupLazyWrites(tx_state);
-            cleanupEagerWrites(tx_state);
+            // the tx aborted or committed), and to apply redo logs.  A
+            // read-only one acquired none.
+            if (!readOnly) {
+                cleanupLazyWrites(tx_state);
+                cleanupEagerWrites(tx_state);
+#ifdef OREC_TABLE
+                releaseOrecs(tx_state);
+#endif
+            }
             // reset read set
             invisibleReads.reset();
 
             // commit memory changes and reset memory logging
             mm.onTxEnd(tx_state);
 
+            // our objects are clean, so whoever parked on us can go on
+            if (parked)
+                cm::BackoffPolicy::wake(&tx_state);
+
+            // let END_TRANSACTION's retry back off, if it should
+            consecutiveAborts = (tx_state == stm::COMMITTED)
+                ? 0 : consecutiveAborts + 1;
+            if (tx_state == stm::ABORTED)
+                cm.onRetry(consecutiveAborts);
+
             // mark ourself as out of accounted time
             timing.UPDATE_TIMING(TIMING_NON_TX);
 
@@ -671,6 +922,11 @@ namespace stm
 
         inline void Descriptor::commit()
         {
+            if (nestDepth > 1) {
+                verifySelf();
+                return;
+            }
+
             timing.UPDATE_TIMING(TIMING_BOOKKEEPING);
 
             // only try to commit if we are still ACTIVE
@@ -678,6 +934,19 @@ namespace stm
                 // Contention Manager notification
                 cm.onTryCommitTx();
 
+                // we published nothing, so once our reads are valid no one
+                // needs to see our state change atomically
+                if (readOnly) {
+                    if (!conflicts.tryCommit()) {
+                        timing.UPDATE_TIMING(TIMING_VALIDATION);
+                        verifyInvisReads();
+                        conflicts.forceCommit();
+                    }
+                    if (tx_state == stm::ACTIVE)
+                        tx_state = stm::COMMITTED;
+                    return;
+                }
+
                 // acquire objects that were open_RW'd lazily
                 if (isLazy)
                     acquireLazily();
@@ -766,6 +1035,13 @@ namespace stm
 
             lazy_bookkeep_t* e = lazyWrites.elements;
 
+#ifdef OREC_TABLE
+            // we still own every orec, so no one else can be looking at the
+            // objects; an aborted log is just dropped
+            if (tx_state == stm::COMMITTED)
+                for (unsigned long i = 0; i < lazyWrites.element_count; i++)
+                    e[i].shared->redo(e[i].redo_log);
+#else
             if (tx_state == stm::ABORTED) {
                 for (unsigned long i = 0; i < lazyWrites.element_count; i++) {
                     if (e[i].isAcq) {
@@ -780,6 +1056,7 @@ namespace stm
                     cleanOnCommit(e[i].shared, this, e[i].redo_log);
                 }
             }
+#endif
             lazyWrites.reset();
         }
 
@@ -792,6 +1069,11 @@ namespace stm
 
             eager_bookkeep_t* e = eagerWrites.elements;
 
+#ifdef OREC_TABLE
+            if (tx_state == stm::COMMITTED)
+                for (unsigned long i = 0; i < eagerWrites.element_count; i++)
+                    e[i].shared->redo(e[i].redo_log);
+#else
             if (tx_state == stm::ABORTED) {
                 for (unsigned long i = 0; i < eagerWrites.element_count; i++)
                     cleanOnAbort(e[i].shared, this, e[i].redo_log);
@@ -801,6 +1083,7 @@ namespace stm
                 for (unsigned long i = 0; i < eagerWrites.element_count; i++)
                     cleanOnCommit(e[i].shared, this, e[i].redo_log);
             }
+#endif
             eagerWrites.reset();
         }
 
@@ -827,6 +1110,18 @@ namespace stm
         inline bool Descriptor::isCurrent(SharedBase* obj,
                                           unsigned long expected_ver) const
         {
+#ifdef OREC_TABLE
+            volatile unsigned long* orec = orec_of(obj);
+            unsigned long o = *orec;
+            if (o == expected_ver)
+                return true;
+
+            // if we own the orec, it still matches if it had expected_ver
+            // when we acquired it
+            unsigned long held;
+            return o == reinterpret_cast<unsigned long>(this)
+                && heldVersion(orec, held) && held == expected_ver;
+#else
             metadata_dword_t snap;
 
             snap.dword = obj->m_metadata.dword;
@@ -849,6 +1144,7 @@ namespace stm
             return
                 snap.fields.redoLog->m_metadata.fields.ver.version ==
                 expected_ver;
+#endif
         }
 
         /**
@@ -866,16 +1162,30 @@ namespace stm
                                         unsigned long exp_ver,
                                         SharedBase* new_log)
         {
+#ifdef OREC_TABLE
+            volatile unsigned long* orec = orec_of(obj);
+
+            // we may already own the orec through another object
+            unsigned long held;
+            if (*orec == reinterpret_cast<unsigned long>(this))
+                return heldVersion(orec, held) && held == exp_ver;
+
+            if (!bool_cas(orec, exp_ver, reinterpret_cast<unsigned long>(this)))
+                return false;
+            heldOrecs.insert(orec_bookkeep_t(orec, exp_ver));
+#else
             if (!casX(&obj->m_metadata.dword, exp_ver, 0,
                       reinterpret_cast<unsigned long>(this),
                       reinterpret_cast<unsigned long>(new_log)))
                 return false;
+#endif
 
             // successfully acquired this Shared<T>
             cm.onOpenWrite();
             return true;
         }
 
+#ifndef OREC_TABLE
         /**
          *  Called to "clean" the shared pointer when a transaction COMMITS
          *  changes.  In this context, "cleaning" means setting the
@@ -911,7 +1221,164 @@ namespace stm
             obj->m_metadata.dword = replace.dword;
             return true;
         }
+#endif
 
+#ifdef OREC_TABLE
+        /**
+         *  Opens /obj/ for reading.  Objects are read in place: the version
+         *  in the orec says if they are current, and anything that hashes to
+         *  an orec we own can't change until we release it.
+         */
+        inline const SharedBase*
+        Descriptor::getReadable(SharedBase* obj, Validator& v)
+        {
+            // make sure all parameters meet our expectations
+            if (!obj)
+                return NULL;
+
+            // set the validator to a null version number; change only if we
+            // don't own /obj/'s orec
+            v.config(0, this);
+
+            // start timing, and ensure this tx isn't aborted
+            timing.UPDATE_TIMING(TIMING_BOOKKEEPING);
+            verifySelf();
+
+            // if we have a RW copy of this that we opened lazily, we must
+            // return it
+            SharedBase* ret = lookupLazyWrite(obj);
+            if (ret) {
+                timing.UPDATE_TIMING(TIMING_REALWORK);
+                return ret;
+            }
+
+            unsigned long ver = readOrec(obj);
+
+            // if we own the orec, we read our redo log if we wrote /obj/, and
+            // /obj/ itself if we only wrote something that hashes with it
+            if (ver == reinterpret_cast<unsigned long>(this)) {
+                ret = lookupEagerWrite(obj);
+                cm.onReOpen();
+                timing.UPDATE_TIMING(TIMING_REALWORK);
+                return ret ? ret : obj;
+            }
+
+            // set up the validator
+            v.config(ver, this);
+
+            // can cause duplicates if we don't use addValidateInvisRead()
+            if (conflicts.shouldValidate()) {
+                if (conflicts.isValidatingInsertSafe()) {
+                    validatingInsert(obj, ver);
+                }
+                else {
+                    invisibleReads.insert(invis_bookkeep_t(obj, ver));
+                    validate();
+                }
+            }
+            else {
+                invisibleReads.insert(invis_bookkeep_t(obj, ver));
+            }
+
+            verifySelf();
+
+            // notify cm and return
+            cm.onOpenRead();
+            timing.UPDATE_TIMING(TIMING_REALWORK);
+            return obj;
+        }
+
+        /**
+         *  Open /obj/ in write mode, by cloning it into a redo log that we
+         *  write back after we commit.  Eager acquire takes the orec now,
+         *  lazy acquire takes it at commit time.
+         */
+        inline SharedBase*
+        Descriptor::getWritable(SharedBase* obj, Validator& v)
+        {
+            assert(!readOnly);
+
+            // make sure all parameters meet our expectations
+            if (!obj)
+                return NULL;
+
+            // set the validator to a null version number
+            v.config(0, this);
+
+            // start timing now, and ensure this tx isn't aborted
+            timing.UPDATE_TIMING(TIMING_BOOKKEEPING);
+            verifySelf();
+
+            // make sure that our conflict detection strategy knows we've got a
+            // write
+            conflicts.onRW();
+
+            // if we already have an RW copy of this, return it
+            SharedBase* ret = lookupLazyWrite(obj);
+            if (!ret)
+                ret = lookupEagerWrite(obj);
+            if (ret) {
+                cm.onReOpen();
+                timing.UPDATE_TIMING(TIMING_REALWORK);
+                return ret;
+            }
+
+            while (true) {
+                unsigned long ver = readOrec(obj);
+
+                // if we own the orec through another object, /obj/ is still
+                // at the version the orec had when we acquired it
+                if (ver == reinterpret_cast<unsigned long>(this))
+                    heldVersion(orec_of(obj), ver);
+
+                // clone the object
+                timing.UPDATE_TIMING(TIMING_COPY);
+
+                SharedBase* new_version = obj->clone();
+
+                assert(new_version);
+                // the clone knows which object it will be written back to
+                new_version->m_master = obj;
+
+                timing.UPDATE_TIMING(TIMING_BOOKKEEPING);
+
+                if (isLazy) {
+                    // LAZY: just add /obj/ to my lazy writeset... don't
+                    // acquire
+                    lazyWrites.insert(lazy_bookkeep_t(obj, new_version, ver));
+                }
+                else {
+                    // EAGER: CAS the orec to me, retry open_RW on failure
+                    if (!acquire(obj, ver, new_version)) {
+                        mm.deleteOnCommit.insert(new_version);
+                        new_version = NULL;
+                        timing.UPDATE_TIMING(TIMING_CM);
+                        cm.onContention();
+                        verifySelf();
+                        continue;
+                    }
+
+                    // CAS succeeded: bookkeep the eager write
+                    eagerWrites.insert(eager_bookkeep_t(obj, new_version));
+                }
+
+                // The redoLog is already deleteOnAbort; mark it deleteOnCommit
+                // too, since it will always be deleted once this tx is
+                // finished
+                mm.deleteOnCommit.insert(new_version);
+
+                // Validate, notify cm, reset timing, and return
+                if (conflicts.shouldValidate()) {
+                    validate();
+                }
+
+                verifySelf();
+                cm.onOpenWrite();
+                timing.UPDATE_TIMING(TIMING_REALWORK);
+                return new_version;
+            } // end while (true)
+        }
+#else
         /**
          *  Opens /this/ for reading.  If /this/ is NULL, returns NULL. If a tx
          *  opens the same Shared<T> twice, the pointers retured will be the
@@ -1002,7 +1469,9 @@ namespace stm
                                           ACTIVE, ABORTED)))
                         {
                             timing.UPDATE_TIMING(TIMING_CM);
-                            cm.onContention();
+                            cm.onContention(
+                                &snap.fields.ver.owner->tx_state,
+                                &snap.fields.ver.owner->parked);
                             verifySelf();
                             timing.UPDATE_TIMING(TIMING_BOOKKEEPING);
                             continue;
@@ -1071,6 +1540,8 @@ namespace stm
         inline SharedBase*
         Descriptor::getWritable(SharedBase* obj, Validator& v)
         {
+            assert(!readOnly);
+
             // make sure all parameters meet our expectations
             if (!obj)
                 return NULL;
@@ -1149,7 +1620,9 @@ namespace stm
                                          ACTIVE, ABORTED))
                         {
                             timing.UPDATE_TIMING(TIMING_CM);
-                            cm.onContention();
+                            cm.onContention(
+                                &snap.fields.ver.owner->tx_state,
+                                &snap.fields.ver.owner->parked);
                             verifySelf();
                             timing.UPDATE_TIMING(TIMING_BOOKKEEPING);
                             continue;
@@ -1231,6 +1704,7 @@ namespace stm
                 return new_version;
             } // end while (true)
         }
+#endif
 
         // make sure that this tx didn't upgrade sh from obj to something new
         inline bool Descriptor::ensure_no_upgrade(const SharedBase* sh,
@@ -1244,6 +1718,14 @@ namespace stm
             if (sh == obj)
                 return true;
 
+#ifdef OREC_TABLE
+            // the orec can't say which object we wrote, but the write sets
+            // can
+            SharedBase* log = lookupEagerWrite(const_cast<SharedBase*>(sh));
+            if (!log)
+                log = lookupLazyWrite(const_cast<SharedBase*>(sh));
+            return log == NULL || log == obj;
+#else
             // read the header of /sh/ to a local
             metadata_dword_t snap;
 
@@ -1270,6 +1752,7 @@ namespace stm
                 return false;
             }
             return true;
+#endif
         }
 
         /**
@@ -1285,6 +1768,23 @@ namespace stm
             if (obj == NULL)
                 return obj;
 
+#ifdef OREC_TABLE
+            volatile unsigned long* orec = orec_of(obj);
+
+            while (true) {
+                unsigned long o = *orec;
+                if (o & 1)
+                    return obj;
+
+                // kill an ACTIVE owner, then wait for it to write back and
+                // release the orec
+                Descriptor* owner = reinterpret_cast<Descriptor*>(o);
+                if (owner->tx_state == ACTIVE)
+                    bool_cas(&(owner->tx_state), ACTIVE, ABORTED);
+                for (int i = 0; i < 128; i++)
+                    nop();
+            }
+#else
             while (true) {
                 // read the header of /this/ to a local, opportunistically get
                 // data ptr
@@ -1356,6 +1856,7 @@ namespace stm
                 // object is clean.  return /this/
                 return obj;
             }
+#endif
 #endif
         }
 
@@ -1368,6 +1869,7 @@ namespace stm
          *  @param expected The object we expect to be current.  @param
          *  replacement The object that we are trying to swap in.
          */
+#ifndef OREC_TABLE
         // to clean on abort, we need to CASX from (owner, log) to (log->ver,
         // NULL)
         inline bool Descriptor::cleanOnAbort(SharedBase* obj,
@@ -1379,6 +1881,7 @@ namespace stm
                         reinterpret_cast<unsigned long>(exp_log),
                         exp_log->m_metadata.fields.ver.version, 0);
         }
+#endif
 
         inline void Descriptor::release(SharedBase* obj)
         {
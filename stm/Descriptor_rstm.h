@@ -37,8 +37,13 @@
 
 // standard requirements for all TMs
 #include <string>
+#include <cstdlib>
+#include <cstring>
+#include <new>
 #include "stm_common.h"
 #include "MiniVector.h"
+#include "ReadSetIndex.h"
+#include "SiteStats.h"
 
 // global commit counter
 #include "ConflictDetector.h"
@@ -60,6 +65,7 @@
 #ifdef USE_BIMODAL
 #include <sched.h>
 #include <iostream>
+#include "BiModalScheduler.h"
 #endif
 
 namespace stm
@@ -75,6 +81,19 @@ namespace stm
         extern volatile unsigned long pcount;
 #endif
 
+        /**
+         *  Global version clock for the clock validation modes.  Every writer
+         *  increments it once it has acquired all of its objects, and stamps
+         *  its new versions with the result before committing.
+         */
+        extern volatile unsigned long global_clock;
+
+        /**
+         *  Nonzero while some transaction runs irrevocably.  New transactions
+         *  wait for it to drop to zero before they start.
+         */
+        extern volatile unsigned long irrevocable_token;
+
         /**
          *  Tuple for storing all the info we need in a lazy write set
          */
@@ -112,11 +131,71 @@ namespace stm
          */
         struct invis_bookkeep_t
         {
-            SharedBase* shared;
-            ObjectBase* read_version;
+            SharedBase*   shared;
+            ObjectBase*   read_version;
+            bool          inPlace;
+            bool          byValue;
+            unsigned long seq;
+
+            invis_bookkeep_t(SharedBase* _sh = NULL, ObjectBase* _rd = NULL,
+                             bool _inPlace = false, bool _byValue = false,
+                             unsigned long _seq = 0)
+                : shared(_sh), read_version(_rd), inPlace(_inPlace),
+                  byValue(_byValue), seq(_seq)
+            { }
+        };
+
+        /**
+         *  Tuple for storing the old value of up to 8 bytes of an object that
+         *  is being written in place
+         */
+        struct undo_bookkeep_t
+        {
+            void*              addr;
+            unsigned long      len;
+            unsigned long long bytes;
+
+            undo_bookkeep_t(void* _addr = NULL, unsigned long _len = 0)
+                : addr(_addr), len(_len), bytes(0)
+            {
+                if (_addr)
+                    memcpy(&bytes, _addr, _len);
+            }
+        };
 
-            invis_bookkeep_t(SharedBase* _sh = NULL, ObjectBase* _rd = NULL)
-                : shared(_sh), read_version(_rd)
+        /**
+         *  Where each log stood when a nested transaction began.  A partial
+         *  abort cuts the logs back to these lengths.
+         */
+        struct nest_checkpoint_t
+        {
+            unsigned long invisibleReads;
+            unsigned long eagerWrites;
+            unsigned long lazyWrites;
+            unsigned long undoLog;
+            unsigned long backups;
+            unsigned long deleteOnCommit;
+            unsigned long deleteOnAbort;
+        };
+
+        /**
+         *  A version that an outer level wrote and a nested level then wrote
+         *  again.  The nested level writes /copy/, and a partial abort puts
+         *  /saved/ back.  /index/ is the entry in the eager or lazy write set.
+         */
+        struct nest_backup_t
+        {
+            SharedBase*   shared;
+            ObjectBase*   saved;
+            ObjectBase*   copy;
+            unsigned long index;
+            bool          lazy;
+
+            nest_backup_t(SharedBase* _sh = NULL, ObjectBase* _saved = NULL,
+                          ObjectBase* _copy = NULL, unsigned long _index = 0,
+                          bool _lazy = false)
+                : shared(_sh), saved(_saved), copy(_copy), index(_index),
+                  lazy(_lazy)
             { }
         };
 
@@ -135,9 +214,13 @@ namespace stm
          *  squash the many levels, but we don't want to have to maintain them,
          *  so we should clean them up.
          *
-         *  [todo] - review the placement of fields.  Some fields are accessed
-         *  by other threads, some aren't.  We should segregate fields into
-         *  different cache lines accordingly.
+         *  Fields are grouped by who touches them.  The first cache line holds
+         *  what other transactions write (tx_state, parked,
+         *  reschedule_core_num), the second what they only read (id, iCore,
+         *  cm), and everything after that is private to the owner thread.  This way a remote CAS on
+         *  tx_state doesn't invalidate the line that holds our read and write
+         *  sets, and remote readers of our id / priority don't share a line
+         *  with fields we write on every open.
          */
         class Descriptor
         {
@@ -145,14 +228,14 @@ namespace stm
             /**
              * state is COMMITTED, ABORTED, or ACTIVE
              */
-            volatile unsigned long tx_state; // definitely read by other
-                                             // transactions
+            volatile unsigned long tx_state // definitely written by other
+            __attribute__ ((aligned(64)));  // transactions
 
             /**
-             *  thread id
+             *  Number of threads parked until this transaction is done; see
+             *  cm::BackoffPolicy
              */
-            const unsigned long id;     // definitely read by other
-                                        // transactions
+            volatile unsigned long parked;  // written by other transactions
 
 #ifdef USE_BIMODAL
 			/**
@@ -160,16 +243,59 @@ namespace stm
 			 * when the transaction rollbacks
 			 */
 			long reschedule_core_num;
-			
+#endif
+
+            /**
+             *  thread id
+             */
+            const unsigned long id      // definitely read by other
+            __attribute__ ((aligned(64)));  // transactions
+
+#ifdef USE_BIMODAL
 			/**
 			 *  the core where this transaction is executed
 			 */
 			unsigned long iCore;
 #endif
+
             /**
-             *  sw vis reader bitmask
+             *  Policy wrapper around a CM
              */
-            unsigned long id_mask;
+            HybridCMPolicy cm;  // definitely read by other transactions
+
+            /**
+             *  If we've turned on profiling instrumentation, this field is
+             *  where we'll store intermediate timing information.  It starts
+             *  the private part of the descriptor.
+             */
+            TimeAccounting timing __attribute__ ((aligned(64)));
+
+#ifdef USE_BIMODAL
+			/**
+			 *  the scheduler whose runner owns this descriptor, NULL for
+			 *  threads that are not runners
+			 */
+			scheduler::BiModalScheduler* scheduler;
+
+			/**
+			 *  true if the current transaction is a fast reader: it runs in
+			 *  a reading epoch while no other kind of transaction does, so
+			 *  its reads are neither logged, validated nor made visible
+			 */
+			bool isFastRead;
+
+			/**
+			 *  Called by a runner once it has a descriptor, so that the
+			 *  descriptor and its CM deal with the right scheduler instance.
+			 *  iCore is the runner's index in that scheduler.
+			 */
+			void attachScheduler(scheduler::BiModalScheduler* sched, int core)
+			{
+				scheduler = sched;
+				iCore = core;
+				cm.onScheduled(sched, core);
+			}
+#endif
 
 #ifdef PRIVATIZATION_NOFENCE
             /**
@@ -180,9 +306,18 @@ namespace stm
 #endif
 
             /**
-             *  Policy wrapper around a CM
+             *  The alignment above only holds if the descriptor itself starts
+             *  on a cache line, which plain new doesn't promise
              */
-            HybridCMPolicy cm;  // definitely read by other transactions
+            static void* operator new(size_t size)
+            {
+                void* mem;
+                if (posix_memalign(&mem, 64, size) != 0)
+                    throw std::bad_alloc();
+                return mem;
+            }
+
+            static void operator delete(void* mem) { free(mem); }
 
             /**
              *  For privatization: check pcount and see if validation is
@@ -244,22 +379,118 @@ namespace stm
             }
 
             /**
-             *  If we've turned on profiling instrumentation, this field is
-             *  where we'll store intermediate timing information.
+             *  How reads are made safe: visible reads, invisible reads with
+             *  incremental validation, or invisible reads validated against
+             *  the global clock (LSA-style)
+             */
+            enum ReadRule { READ_VISIBLE, READ_INVISIBLE, READ_CLOCK };
+
+            /**
+             *  The -V choices, one per read rule and acquire rule pair
+             */
+            enum TxMode {
+                MODE_VIS_EAGER,   MODE_VIS_LAZY,
+                MODE_INVIS_EAGER, MODE_INVIS_LAZY,
+                MODE_CLOCK_EAGER, MODE_CLOCK_LAZY,
+                MODE_IRREVOCABLE
+            };
+
+            /**
+             *  The read and acquire rules of the current transaction.
+             *  open_RO, open_RW and commit switch on this once and run an
+             *  instantiation specialized for it, so the rules cost no
+             *  branches inside the instrumentation.
+             */
+            TxMode mode;
+
+            /**
+             *  true if mode validates against the global clock
+             */
+            bool isClock() const
+            {
+                return mode == MODE_CLOCK_EAGER || mode == MODE_CLOCK_LAZY;
+            }
+
+            /**
+             *  With -V adaptive, every BEGIN_TRANSACTION site gets its own
+             *  mode, picked from how its earlier attempts went.  curSite is
+             *  the entry of the running transaction, NULL if its mode is
+             *  fixed.
+             */
+            bool isAdaptive;
+            SiteStats siteStats;
+            SiteStats::site_t* curSite;
+
+            /**
+             *  Pick the mode for the next attempt at a site: visible reads
+             *  once its read sets are long enough that incremental
+             *  validation costs more than the reader indicators, lazy
+             *  acquire once it aborts often enough that holding objects
+             *  from open to commit hurts.  Clock modes need every thread to
+             *  stamp its writes, so they are never picked.
+             */
+            TxMode adaptMode(const SiteStats::site_t& s) const;
+
+            /**
+             *  An irrevocable transaction holds irrevocable_token and runs
+             *  with every other transaction drained, so it opens the current
+             *  version of each object directly and can never abort.
+             *  savedMode is the mode to go back to afterwards.
+             *
+             *  The token doubles as the fallback lock: once a thread has
+             *  aborted stm::fallback_threshold times in a row, its next
+             *  attempt takes it.  Every transaction subscribes to the lock
+             *  when it begins, so the fallback aborts the running ones
+             *  rather than wait for them.
+             */
+            TxMode savedMode;
+            unsigned long consecutiveAborts;
+
+            /**
+             *  true if the top-level transaction began with
+             *  BEGIN_RO_TRANSACTION.  It logs no allocations, keeps no
+             *  write set and commits with a plain store.  Nested levels run
+             *  under the flag of the top level.
+             */
+            bool readOnly;
+
+            /**
+             *  Take the token and wait for every other transaction to
+             *  finish.  If /evict/, abort them first.
+             */
+            void becomeIrrevocable(bool evict);
+
+            /**
+             *  Don't start while some other transaction is irrevocable
              */
-            TimeAccounting timing;
+            void waitForIrrevocable();
 
             /**
-             *  flag indicating if the current transaction is using lazy or
-             *  eager acquire.
+             *  In clock mode, the global clock time up to which every object
+             *  in our read set is known to be current
              */
-            bool isLazy;
+            unsigned long start_ts;
 
             /**
-             *  flag indicating if the current transaction is using visible or
-             *  invisible reads.
+             *  In clock mode, move start_ts to now if the read set is still
+             *  valid, abort otherwise
              */
-            bool isVisible;
+            void extendSnapshot();
+
+            /**
+             *  In clock mode, stamp every version we are about to commit
+             *  with our commit time
+             */
+            void stampWrites(unsigned long ts);
+
+#ifdef MULTI_VERSION
+            /**
+             *  m_ts of a version whose writer is taking its commit time.  A
+             *  snapshot reader that sees it can't tell which side of its
+             *  snapshot the commit will fall on, and waits.
+             */
+            static const unsigned long TS_PENDING = ~0UL;
+#endif
 
             /**
              *  Interface to thread-local allocator that manages reclamation on
@@ -268,15 +499,59 @@ namespace stm
             DeferredReclamationMMPolicy mm;
 
             /**
-             *  Set all metadata up for a new transaction, and move to ACTIVE
+             *  Set all metadata up for a new transaction, and move to ACTIVE.
+             *  /site/ identifies the BEGIN_TRANSACTION that started it.  If
+             *  /irrevocable/, the transaction runs irrevocably.  If
+             *  /readOnly/, it promises never to open anything for writing.
              */
-            void beginTransaction();
+            void beginTransaction(const void* site = NULL,
+                                  bool irrevocable = false,
+                                  bool readOnly = false);
 
             /**
              *  Attempt to commit a transaction
              */
             void commit();
 
+          private:
+            /**
+             *  commit, open_RO and open_RW for one read rule / acquire rule
+             *  pair.  LAZY is the acquire rule.
+             */
+            template <bool LAZY, ReadRule READS>
+            void commitImpl();
+
+            template <bool LAZY, ReadRule READS>
+            const ObjectBase* openReadImpl(SharedBase* header, Validator& v);
+
+            template <bool LAZY, ReadRule READS>
+            ObjectBase* openWriteImpl(SharedBase* header, Validator& v);
+
+            /**
+             *  commit, open_RO and open_RW for MODE_IRREVOCABLE
+             */
+            void commitIrrevocable();
+            const ObjectBase* openReadIrrevocable(SharedBase* header,
+                                                  Validator& v);
+            ObjectBase* openWriteIrrevocable(SharedBase* header, Validator& v);
+
+            /**
+             *  commit for a declared read-only transaction
+             */
+            void commitReadOnly();
+
+#ifdef MULTI_VERSION
+            /**
+             *  open_RO for a declared read-only transaction in a clock mode:
+             *  return the version that was current at start_ts.  Never
+             *  logs, validates or aborts anyone.
+             */
+            const ObjectBase* openReadSnapshot(SharedBase* header,
+                                               Validator& v);
+#endif
+
+          public:
+
             /**
              *  abort a transaction.  Usually we want to throw Aborted(), but
              *  use the flag in case we're in a special case where throwing is
@@ -284,6 +559,21 @@ namespace stm
              */
             void abort(bool shouldThrow = true);
 
+#ifdef ABORT_LONGJMP
+            /**
+             *  The checkpoint of the innermost BEGIN_TRANSACTION.  With
+             *  ABORT_MECHANISM=LONGJMP, an abort jumps back to it instead of
+             *  throwing Aborted.  NULL outside a transaction.
+             */
+            jmp_buf* checkpoint;
+#endif
+
+            /**
+             *  Leave the transaction body for its END_TRANSACTION, by
+             *  throwing Aborted or by jumping to the checkpoint
+             */
+            void unwind() __attribute__((noreturn));
+
             /**
              *  Clean up after a transaction, return true if the tx is
              *  COMMITTED.  This cleans up all the metadata within the
@@ -347,16 +637,38 @@ namespace stm
             void cleanupLazyWrites(unsigned long tx_state);
 
             /**
-             *  Combine add / lookup / validate in the read set.  This lets me
-             *  avoid duplicate entries.  If I'm opening O, instead of looking
-             *  up O in my read set I just assume it's new, open it, and then
-             *  use a validating add.  For each object in the set, I validate
-             *  the object.  Then, if that object is O, I can quit early.
-             *  Otherwise, once I'm done traversing the list I add O, and I've
-             *  both validated and ensured no duplicates.
+             *  Combine add / validate in the read set: validate every object
+             *  in the set, then add O unless the index says it is already
+             *  there.
              */
             void addValidateInvisRead(SharedBase* shared, ObjectBase* version);
 
+            /**
+             *  Add an entry to the invisible read set unless the index finds
+             *  that /shared/ is already in it.  O(1), and no validation.
+             */
+            void insertInvisRead(SharedBase* shared, ObjectBase* version);
+
+            /**
+             *  Use the index to find /shared/ in the invisible read set.
+             *  Returns false if it isn't there.
+             */
+            bool findInvisRead(SharedBase* shared, unsigned long& pos) const;
+
+            /**
+             *  Check one entry of the invisible read set.  Objects written in
+             *  place must also have the sequence number we read, and objects
+             *  validated by value may have any version of the same value.
+             */
+            bool isCurrentRead(const invis_bookkeep_t& e) const;
+
+            /**
+             *  True if the committed version of /header/ holds the same value
+             *  as /expected/.  Only looks; never cleans up the header.
+             */
+            bool isSameValue(const SharedBase* header,
+                             const ObjectBase* expected) const;
+
             /**
              *  Validate the invisible read and lazy write sets
              */
@@ -392,6 +704,12 @@ namespace stm
              */
             MiniVector<invis_bookkeep_t> invisibleReads;
 
+            /**
+             *  Hash index over the invisible read list, so that duplicates
+             *  are found without walking the list
+             */
+            ReadSetIndex invisibleIndex;
+
             /**
              *  The visible read list
              */
@@ -407,6 +725,81 @@ namespace stm
              */
             MiniVector<lazy_bookkeep_t> lazyWrites;
 
+            /**
+             *  Old bytes of the objects we are writing in place
+             */
+            MiniVector<undo_bookkeep_t> undoLog;
+
+            /**
+             *  Write back the undo log from entry /from/ on, newest first
+             */
+            void restoreUndoLog(unsigned long from = 0);
+
+            /**
+             *  Closed nesting.  nestDepth is 0 outside a transaction and 1 in
+             *  a top-level one; each BEGIN_TRANSACTION inside a transaction
+             *  pushes a checkpoint of the logs on nestLevels.  A conflict that
+             *  leaves the outer levels' reads valid only rolls the logs back
+             *  to the innermost checkpoint and retries that level
+             *  (partialAbort marks such an abort).  Everything else aborts
+             *  the whole transaction, as does anything that aborts us
+             *  remotely: the enemy can't tell which level it hit.
+             */
+            unsigned long nestDepth;
+            bool partialAbort;
+            MiniVector<nest_checkpoint_t> nestLevels;
+
+            /**
+             *  Versions an outer level wrote that some nested level wrote
+             *  again; see backupForLevel()
+             */
+            MiniVector<nest_backup_t> nestBackups;
+
+            /**
+             *  Begin a transaction nested in the current one
+             */
+            void beginNested();
+
+            /**
+             *  cleanup() for a nested transaction: merge it into its parent,
+             *  roll it back for a retry, or pass a full abort outward
+             */
+            bool cleanupNested();
+
+            /**
+             *  true if every read and lazy write the enclosing levels made is
+             *  still valid, so that an abort can stop at the current level
+             */
+            bool outerLevelsValid() const;
+
+            /**
+             *  Undo everything the current level did since /cp/
+             */
+            void rollbackTo(const nest_checkpoint_t& cp);
+
+            /**
+             *  /version/ is our write version of /header/.  If an enclosing
+             *  level wrote it, switch to a fresh copy so that a partial
+             *  abort can go back to /version/, and return the copy.
+             */
+            ObjectBase* backupForLevel(SharedBase* header, ObjectBase* version,
+                                       bool lazy);
+
+            /**
+             *  Release an object we wrote in place.  On commit, bump its
+             *  sequence number so that readers of the old values fail
+             *  validation.
+             */
+            static void releaseInPlace(SharedBase* header, ObjectBase* obj,
+                                       bool committed);
+
+            /**
+             *  An object written in place by someone else has no older
+             *  version we could use.  Let the CM decide whether to abort the
+             *  owner, then back off until the owner has released it.
+             */
+            void waitInPlace(Descriptor* owner, unsigned long ownerState);
+
           public:
             /**
              *  MM wrapper for scheduling an object to be deleted if the
@@ -513,6 +906,19 @@ namespace stm
              */
             bool ensure_no_upgrade(const SharedBase* sh,
                                    const ObjectBase* obj) const;
+
+            /**
+             *  Called by the setters of an object we are writing in place,
+             *  before they overwrite /len/ bytes at /addr/
+             */
+            void logUndo(void* addr, size_t len);
+
+            /**
+             *  Called after each read of an object opened for reading in
+             *  place: abort if a writer holds it or has changed it since we
+             *  saw sequence number /seq/
+             */
+            void verifyInPlaceRead(const ObjectBase* obj, unsigned long seq);
         };  // class Descriptor
 
         /**
@@ -525,14 +931,26 @@ namespace stm
              *  hit to get it.
              */
             Descriptor* m_tx;
+
+            /**
+             *  The object we opened for reading, if writers update it in
+             *  place, and its sequence number when we opened it
+             */
+            const ObjectBase* m_inPlace;
+            unsigned long m_seq;
           public:
 
+            Validator() : m_tx(NULL), m_inPlace(NULL), m_seq(0) { }
+
             /**
              *  If we're in a transaction, make sure that a privatizer didn't
-             *  commit.
+             *  commit, and that an object written in place didn't change
+             *  under the read we just did.
              */
             void validate(const void*) const
             {
+                if (m_inPlace)
+                    m_tx->verifyInPlaceRead(m_inPlace, m_seq);
                 if (m_tx)
                     m_tx->check_pcount();
             }
@@ -543,6 +961,16 @@ namespace stm
             void config(Descriptor* tx)
             {
                 m_tx = tx;
+                m_inPlace = NULL;
+            }
+
+            /**
+             *  Make validate() check reads of an object written in place
+             */
+            void configInPlace(const ObjectBase* obj, unsigned long seq)
+            {
+                m_inPlace = obj;
+                m_seq = seq;
             }
         };
 
@@ -575,27 +1003,70 @@ namespace stm
         internal::get_descriptor()->mm.txFree(ptr);
     }
 
+    /**
+     *  Abort the running transaction and start it over
+     */
+    inline void restart()
+    {
+        internal::get_descriptor()->abort();
+    }
+
     namespace internal
     {
-        inline void Descriptor::abort(bool shouldAbort)
+        inline void Descriptor::abort(bool shouldThrow)
         {
             timing.UPDATE_TIMING(TIMING_BOOKKEEPING);
+
+            // an irrevocable transaction's writes can't be undone; only an
+            // exception leaving it (shouldThrow false) gets here, and a
+            // nested level just lets it pass
+            assert(mode != MODE_IRREVOCABLE || !shouldThrow);
+            if (nestDepth > 1 && mode == MODE_IRREVOCABLE)
+                return;
+
+            // if only the innermost level is in trouble, retry just that
+            // level.  An exception leaving a nested level always stops
+            // there; the enclosing levels decide what to do with it.
+            bool partial = nestDepth > 1 && tx_state == ACTIVE
+                && (!shouldThrow || outerLevelsValid());
+#ifdef USE_BIMODAL
+            // a fast reader must retry as a normal transaction
+            partial = partial && !isFastRead;
+#endif
+            if (partial) {
+                partialAbort = true;
+                if (shouldThrow)
+                    unwind();
+                return;
+            }
+
             tx_state = ABORTED;
 
             // Contention Manager notification
             cm.onTxAborted();
 
-            if (shouldAbort) {
+            if (shouldThrow) {
 #ifdef USE_BIMODAL
 			if (reschedule_core_num != -1) {
 				cm.onConflictWith(reschedule_core_num);
 				reschedule_core_num = -1;
 			}
 #endif
-                throw Aborted();
+                unwind();
             }
         }
 
+        inline void Descriptor::unwind()
+        {
+#ifdef ABORT_LONGJMP
+            // _longjmp leaves the signal mask alone, so this is a handful of
+            // register loads instead of a walk of the unwind tables
+            _longjmp(*checkpoint, 1);
+#else
+            throw Aborted();
+#endif
+        }
+
         inline void Descriptor::validate()
         {
             // Update timing, then do validation
@@ -605,6 +1076,26 @@ namespace stm
             verifyLazyWrites();
         }
 
+        inline void Descriptor::extendSnapshot()
+        {
+            // read the clock first: whatever validates after that is
+            // current as of /now/
+            unsigned long now = global_clock;
+            validate();
+            start_ts = now;
+        }
+
+        inline void Descriptor::stampWrites(unsigned long ts)
+        {
+            eager_bookkeep_t* e = eagerWrites.elements;
+            for (unsigned long i = 0; i < eagerWrites.element_count; i++)
+                e[i].write_version->m_ts = ts;
+
+            lazy_bookkeep_t* l = lazyWrites.elements;
+            for (unsigned long i = 0; i < lazyWrites.element_count; i++)
+                l[i].write_version->m_ts = ts;
+        }
+
         inline void Descriptor::validatingInsert(SharedBase* sh,
                                                  ObjectBase* ver)
         {
@@ -625,19 +1116,109 @@ namespace stm
             }
         }
 
-        inline void Descriptor::beginTransaction()
+        inline Descriptor::TxMode
+        Descriptor::adaptMode(const SiteStats::site_t& s) const
         {
+            bool visible = s.avgReads >= SiteStats::LONG_READS
+                && ReaderIndicator::supports(id);
+            bool lazy = s.aborts * 4 > s.commits;
+            if (visible)
+                return lazy ? MODE_VIS_LAZY : MODE_VIS_EAGER;
+            return lazy ? MODE_INVIS_LAZY : MODE_INVIS_EAGER;
+        }
+
+        inline void Descriptor::becomeIrrevocable(bool evict)
+        {
+            while (!bool_cas(&irrevocable_token, 0, 1))
+                while (irrevocable_token)
+                    nop();
+
+            // transactions that started before we took the token run to
+            // the end, later ones wait in waitForIrrevocable()
+            mm.onTxBegin(!readOnly);
+            if (evict) {
+                ConflictCounter[id].ADD_FALLBACK();
+                unsigned long threads = idManager.getThreadCount();
+                for (unsigned long i = 0; i < threads; i++) {
+                    Descriptor* tx = desc_array[i];
+                    if (tx && tx != this
+                        && bool_cas(&(tx->tx_state), ACTIVE, ABORTED))
+                        ConflictCounter[id].ADD_EXPLICIT_ABORT();
+                }
+            }
+            globalEpoch.waitForQuiescence(id);
+
+            savedMode = mode;
+            mode = MODE_IRREVOCABLE;
+            ConflictCounter[id].ADD_IRREVOCABLE();
+        }
+
+        inline void Descriptor::waitForIrrevocable()
+        {
+            mm.onTxBegin(!readOnly);
+
+            // an irrevocable transaction takes the token and then checks our
+            // epoch entry, so we must check the token after entering
+            membar();
+            while (irrevocable_token) {
+                globalEpoch.exit_transaction(id);
+                while (irrevocable_token)
+                    nop();
+                globalEpoch.enter_transaction(id);
+                membar();
+            }
+        }
+
+        inline void Descriptor::beginTransaction(const void* site,
+                                                 bool irrevocable,
+                                                 bool readOnly)
+        {
+            // the mode, the token and the read-only flag belong to the top
+            // level
+            if (nestDepth) {
+                beginNested();
+                return;
+            }
+            nestDepth = 1;
+            this->readOnly = readOnly;
+
             timing.UPDATE_TIMING(TIMING_BOOKKEEPING);
 
             conflicts.onTxBegin();
-            mm.onTxBegin();
+
+            // the mode can only change between transactions
+            if (isAdaptive && site) {
+                curSite = &siteStats.lookup(site, MODE_INVIS_EAGER);
+                mode = static_cast<TxMode>(curSite->mode);
+            }
+
+            if (fallback_threshold && consecutiveAborts >= fallback_threshold)
+                becomeIrrevocable(true);
+            else if (irrevocable)
+                becomeIrrevocable(false);
+            else
+                waitForIrrevocable();
 
             // mark myself active
             tx_state = ACTIVE;
 
+            // take our snapshot
+            if (isClock())
+                start_ts = global_clock;
+
             // cm notification
             cm.onBeginTx();
 
+#ifdef USE_BIMODAL
+            // pick the fast read mode if the epoch allows it; any other
+            // transaction keeps fast readers out until its cleanup
+            if (scheduler) {
+                isFastRead = scheduler->enterFastRead(iCore);
+                if (!isFastRead)
+                    scheduler->enterTx(iCore);
+            }
+#endif
+
             timing.UPDATE_TIMING(TIMING_REALWORK);
         }
 
@@ -654,15 +1235,38 @@ namespace stm
             }
         }
 
+        inline bool Descriptor::findInvisRead(SharedBase* shared,
+                                              unsigned long& pos) const
+        {
+            // the index may be stale, trust it only if the list agrees
+            return invisibleIndex.lookup(shared, pos)
+                && pos < invisibleReads.element_count
+                && invisibleReads.elements[pos].shared == shared;
+        }
+
+        inline void Descriptor::insertInvisRead(SharedBase* shared,
+                                                ObjectBase* version)
+        {
+            unsigned long pos;
+            if (findInvisRead(shared, pos))
+                return;
+            invisibleIndex.insert(shared, invisibleReads.element_count);
+            invisibleReads.insert(invis_bookkeep_t(shared, version,
+                                                   version->m_inPlace,
+                                                   version->m_byValue,
+                                                   version->m_ts));
+        }
+
         inline void Descriptor::removeInvisRead(SharedBase* shared)
         {
-            invis_bookkeep_t* e = invisibleReads.elements;
-            for (unsigned long i = 0; i < invisibleReads.element_count; i++) {
-                if (e[i].shared == shared) {
-                    invisibleReads.remove(i);
-                    return;
-                }
-            }
+            unsigned long pos;
+            if (!findInvisRead(shared, pos))
+                return;
+
+            // remove() moves the last entry into /pos/
+            invisibleReads.remove(pos);
+            if (pos < invisibleReads.element_count)
+                invisibleIndex.insert(invisibleReads.elements[pos].shared, pos);
         }
 
         inline ObjectBase* Descriptor::lookupLazyWrite(SharedBase* shared)
@@ -696,8 +1300,8 @@ namespace stm
                                       std::string dynamic_cm,
                                       std::string validation,
                                       bool _use_static_cm)
-            : // set up the id, build bitmap mask based on the ID
-            id(_id), id_mask(1 << _id),
+            : // set up the id
+            id(_id),
             // set up CM
             cm(_use_static_cm, dynamic_cm),
             // set up the DeferredReclamationMMPolicy object
@@ -705,14 +1309,20 @@ namespace stm
             // construct bookkeeping fields that depend on the heap
             conflicts(),
             invisibleReads(mm.getHeap(), 64),
+            invisibleIndex(mm.getHeap(), 128),
             visibleReads(mm.getHeap(), 64),
             eagerWrites(mm.getHeap(), 64),
-            lazyWrites(mm.getHeap(), 64)
+            lazyWrites(mm.getHeap(), 64),
+            undoLog(mm.getHeap(), 64),
+            nestLevels(mm.getHeap(), 8),
+            nestBackups(mm.getHeap(), 8)
         {
 			
 #ifdef USE_BIMODAL
 			iCore = sched_getcpu();
 			reschedule_core_num = -1;
+			scheduler = NULL;
+			isFastRead = false;
 			
 #endif
             // the state is COMMITTED, in tx #0
@@ -724,17 +1334,51 @@ namespace stm
 
             // set up the acquire and read rules
             // for now, the read ruls is the max number of visible readers
-            if (validation == "invis-eager" || validation == "invis-lazy" ||
-                _id > 31)
-                isVisible = false;
+            start_ts = 0;
+            isAdaptive = false;
+            curSite = NULL;
+            consecutiveAborts = 0;
+            readOnly = false;
+            parked = 0;
+#ifdef ABORT_LONGJMP
+            checkpoint = NULL;
+#endif
+            nestDepth = 0;
+            partialAbort = false;
+            if (validation == "adaptive") {
+                isAdaptive = true;
+                mode = MODE_INVIS_EAGER;
+            }
+            else if (validation == "clock-eager")
+                mode = MODE_CLOCK_EAGER;
+            else if (validation == "clock-lazy")
+                mode = MODE_CLOCK_LAZY;
+            else if (validation == "invis-eager")
+                mode = MODE_INVIS_EAGER;
+            else if (validation == "invis-lazy")
+                mode = MODE_INVIS_LAZY;
+            else if (validation == "vis-eager")
+                mode = MODE_VIS_EAGER;
             else
-                isVisible = true;
+                mode = MODE_VIS_LAZY;
+
+#ifdef IN_PLACE_WRITES
+            // an in-place commit bumps m_ts as a sequence number rather than
+            // stamping the clock, so clock readers can't use it
+            if (mode == MODE_CLOCK_EAGER)
+                mode = MODE_INVIS_EAGER;
+            else if (mode == MODE_CLOCK_LAZY)
+                mode = MODE_INVIS_LAZY;
+#endif
 
-            // for now, the acquire rule is boolean; 1=eager
-            if (validation == "invis-eager" || validation == "vis-eager")
-                isLazy = false;
-            else
-                isLazy = true;
+            // threads past what the reader indicator can hold read
+            // invisibly
+            if (!ReaderIndicator::supports(_id)) {
+                if (mode == MODE_VIS_EAGER)
+                    mode = MODE_INVIS_EAGER;
+                else if (mode == MODE_VIS_LAZY)
+                    mode = MODE_INVIS_LAZY;
+            }
 
             // set up the timing fields
             timing = TimeAccounting();
@@ -742,6 +1386,12 @@ namespace stm
 
         inline bool Descriptor::cleanup()
         {
+            if (nestDepth > 1)
+                return cleanupNested();
+            nestDepth = 0;
+            partialAbort = false;
+            nestBackups.reset();
+
             timing.UPDATE_TIMING(TIMING_BOOKKEEPING);
 
             // invariant: status == COMMITTED or ABORTED
@@ -754,22 +1404,63 @@ namespace stm
             else
                 cm.onTxAborted();
 
+            // learn from this attempt before its logs are reset, so that a
+            // retry already runs in the updated mode
+            if (curSite) {
+                SiteStats::record(*curSite, tx_state == COMMITTED,
+                                  invisibleReads.element_count
+                                  + visibleReads.element_count,
+                                  eagerWrites.element_count
+                                  + lazyWrites.element_count);
+                curSite->mode = adaptMode(*curSite);
+                curSite = NULL;
+            }
+
             // clean up the descriptor
 
             // at the end of a transaction, we are supposed to restore the
             // headers of any objects that we acquired (regardless of whether
-            // the tx aborted or committed).
-            cleanupLazyWrites(tx_state);
-            cleanupEagerWrites(tx_state);
+            // the tx aborted or committed).  A read-only one acquired none.
+            if (!readOnly) {
+                cleanupLazyWrites(tx_state);
+                cleanupEagerWrites(tx_state);
+            }
 
             // clean up read sets: uninstall myself from any objects I have
             // open for reading visibly, null out my invis read list
             cleanupVisReads();
             invisibleReads.reset();
+            invisibleIndex.reset();
 
             // commit memory changes and reset memory logging
             mm.onTxEnd(tx_state);
 
+#ifdef USE_BIMODAL
+            // our headers are restored, so fast readers may run again
+            if (scheduler) {
+                if (isFastRead)
+                    scheduler->leaveFastRead(iCore);
+                else
+                    scheduler->leaveTx(iCore);
+                isFastRead = false;
+            }
+#endif
+
+            if (mode == MODE_IRREVOCABLE) {
+                mode = savedMode;
+                irrevocable_token = 0;
+            }
+            consecutiveAborts = (tx_state == COMMITTED)
+                ? 0 : consecutiveAborts + 1;
+
+            // our headers are clean, so whoever parked on us can go on
+            if (parked)
+                cm::BackoffPolicy::wake(&tx_state);
+
+            // let END_TRANSACTION's retry back off, if it should
+            if (tx_state == ABORTED)
+                cm.onRetry(consecutiveAborts);
+
             // mark ourself as out of accounted time
             timing.UPDATE_TIMING(TIMING_NON_TX);
 
@@ -780,7 +1471,8 @@ namespace stm
             return tx_state == COMMITTED;
         }
 
-        inline void Descriptor::commit()
+        template <bool LAZY, Descriptor::ReadRule READS>
+        inline void Descriptor::commitImpl()
         {
             timing.UPDATE_TIMING(TIMING_BOOKKEEPING);
 
@@ -789,12 +1481,39 @@ namespace stm
                 // Contention Manager notification
                 cm.onTryCommitTx();
 
+#ifdef USE_BIMODAL
+                // a fast reader has nothing to acquire or validate
+                if (isFastRead) {
+                    bool_cas(&(tx_state), ACTIVE, COMMITTED);
+                    return;
+                }
+#endif
+
                 // acquire objects that were open_RW'd lazily
-                if (isLazy)
+                if (LAZY)
                     acquireLazily();
 
                 // validate if necessary
-                if (!conflicts.tryCommit()) {
+                if (READS == READ_CLOCK) {
+                    // a reader's snapshot is consistent as it stands.  A
+                    // writer takes its commit time once it owns everything,
+                    // and need not validate if no one committed since our
+                    // snapshot.
+                    if (!eagerWrites.is_empty() || !lazyWrites.is_empty()) {
+#ifdef MULTI_VERSION
+                        // snapshot readers must see that a commit time is
+                        // coming before we take it
+                        stampWrites(TS_PENDING);
+#endif
+                        unsigned long ts = fai(&global_clock) + 1;
+                        stampWrites(ts);
+                        if (ts != start_ts + 1) {
+                            timing.UPDATE_TIMING(TIMING_VALIDATION);
+                            verifyInvisReads();
+                        }
+                    }
+                }
+                else if (!conflicts.tryCommit()) {
                     timing.UPDATE_TIMING(TIMING_VALIDATION);
                     verifyInvisReads();
                     conflicts.forceCommit();
@@ -815,10 +1534,43 @@ namespace stm
 
             SharedBase** e = visibleReads.elements;
 
-            for (unsigned long i = 0; i < visibleReads.element_count; i++)
-                removeVisibleReader(e[i]);
+            for (unsigned long i = 0; i < visibleReads.element_count; i++)
+                removeVisibleReader(e[i]);
+
+            visibleReads.reset();
+        }
+
+        inline bool Descriptor::isCurrentRead(const invis_bookkeep_t& e) const
+        {
+            // an object written in place stays the current version, so ask
+            // its sequence number whether a writer committed since our read
+            if (isCurrent(e.shared, e.read_version))
+                return !e.inPlace || e.read_version->m_ts == e.seq;
+
+            // versions are never changed once committed, and ours won't be
+            // reclaimed before we finish, so an equal value keeps every read
+            // we made from it consistent
+            return e.byValue && isSameValue(e.shared, e.read_version);
+        }
+
+        inline bool Descriptor::isSameValue(const SharedBase* header,
+                                            const ObjectBase* expected) const
+        {
+            ObjectBase* snap = const_cast<ObjectBase*>(header->m_payload);
+            ObjectBase* curr = get_data_ptr(snap);
+
+            if (is_owned(snap)) {
+                // until its owner commits, the older version is the current
+                // one; the header must not move while we ask
+                if (curr->m_owner->tx_state != COMMITTED)
+                    curr = curr->m_next;
+                if (header->m_payload != snap)
+                    return false;
+            }
 
-            visibleReads.reset();
+            if (!curr)
+                return false;
+            return curr == expected || curr->sameValue(expected);
         }
 
         inline void Descriptor::verifyInvisReads()
@@ -829,7 +1581,7 @@ namespace stm
             invis_bookkeep_t* e = invisibleReads.elements;
 
             for (unsigned long i = 0; i < invisibleReads.element_count; i++) {
-                if (!isCurrent(e[i].shared, e[i].read_version)) {
+                if (!isCurrentRead(e[i])) {
                     ConflictCounter[id].ADD_VALIDATION_FAIL();
                     std::cout << "invisible reader\n";
                     abort();
@@ -840,23 +1592,16 @@ namespace stm
         inline void Descriptor::addValidateInvisRead(SharedBase* shared,
                                                      ObjectBase* version)
         {
-            if (invisibleReads.is_empty()) {
-                invisibleReads.insert(invis_bookkeep_t(shared, version));
-                return;
-            }
-
             invis_bookkeep_t* e = invisibleReads.elements;
 
             for (unsigned long i = 0; i < invisibleReads.element_count; i++) {
-                if (!isCurrent(e[i].shared, e[i].read_version)) {
+                if (!isCurrentRead(e[i])) {
                     ConflictCounter[id].ADD_VALIDATION_FAIL();
                     std::cout << "adding visible reader";
                     abort();
                 }
-                if (e[i].shared == shared)
-                    return;
             }
-            invisibleReads.insert(invis_bookkeep_t(shared, version));
+            insertInvisRead(shared, version);
         }
 
         inline void Descriptor::verifyLazyWrites()
@@ -929,16 +1674,91 @@ namespace stm
 
             eager_bookkeep_t* e = eagerWrites.elements;
             if (tx_state == stm::ABORTED) {
-                for (unsigned long i = 0; i < eagerWrites.element_count; i++)
-                    cleanOnAbort(e[i].shared, e[i].write_version,
-                                 e[i].read_version);
+                // objects written in place get their old bytes back before
+                // anyone else can see them again
+                restoreUndoLog();
+                for (unsigned long i = 0; i < eagerWrites.element_count; i++) {
+                    if (e[i].write_version == e[i].read_version)
+                        releaseInPlace(e[i].shared, e[i].write_version, false);
+                    else
+                        cleanOnAbort(e[i].shared, e[i].write_version,
+                                     e[i].read_version);
+                }
             }
             else {
                 assert(tx_state == stm::COMMITTED);
-                for (unsigned long i = 0; i < eagerWrites.element_count; i++)
-                    cleanOnCommit(e[i].shared, e[i].write_version);
+                for (unsigned long i = 0; i < eagerWrites.element_count; i++) {
+                    if (e[i].write_version == e[i].read_version)
+                        releaseInPlace(e[i].shared, e[i].write_version, true);
+                    else
+                        cleanOnCommit(e[i].shared, e[i].write_version);
+                }
             }
             eagerWrites.reset();
+            undoLog.reset();
+        }
+
+        inline void Descriptor::logUndo(void* addr, size_t len)
+        {
+            char* bytes = static_cast<char*>(addr);
+            for (size_t off = 0; off < len; off += sizeof(unsigned long long)) {
+                size_t chunk = len - off;
+                if (chunk > sizeof(unsigned long long))
+                    chunk = sizeof(unsigned long long);
+                undoLog.insert(undo_bookkeep_t(bytes + off, chunk));
+            }
+        }
+
+        inline void Descriptor::restoreUndoLog(unsigned long from)
+        {
+            undo_bookkeep_t* e = undoLog.elements;
+            for (unsigned long i = undoLog.element_count; i > from; i--)
+                memcpy(e[i - 1].addr, &e[i - 1].bytes, e[i - 1].len);
+        }
+
+        inline void Descriptor::releaseInPlace(SharedBase* header,
+                                               ObjectBase* obj,
+                                               bool committed)
+        {
+            // readers look at m_next before m_ts, so the new sequence number
+            // must be visible by the time the sentinel goes away
+            cfence();
+            if (committed)
+                obj->m_ts = obj->m_ts + 1;
+            obj->m_next = NULL;
+            swapHeader(header, set_lsb(obj), obj);
+        }
+
+        inline void Descriptor::waitInPlace(Descriptor* owner,
+                                            unsigned long ownerState)
+        {
+            if (ownerState == ACTIVE) {
+                ConflictCounter[id].ADD_CONFLICT();
+                if (cm.shouldAbort(owner->cm.getCM())
+                    && bool_cas(&(owner->tx_state), ACTIVE, ABORTED))
+                {
+                    ConflictCounter[id].ADD_EXPLICIT_ABORT();
+#ifdef USE_BIMODAL
+                    owner->reschedule_core_num = iCore;
+#endif
+                }
+            }
+            timing.UPDATE_TIMING(TIMING_CM);
+            cm.onContention(&owner->tx_state, &owner->parked);
+            verifySelf();
+        }
+
+        inline void Descriptor::verifyInPlaceRead(const ObjectBase* obj,
+                                                  unsigned long seq)
+        {
+            // the caller's read of the field must not move below this
+            cfence();
+            if ((obj->m_next == obj && obj->m_owner != this)
+                || obj->m_ts != seq)
+            {
+                ConflictCounter[id].ADD_VALIDATION_FAIL();
+                abort();
+            }
         }
 
         inline void Descriptor::addDtor(SharedBase* sh)
@@ -1008,12 +1828,18 @@ namespace stm
                                                     ObjectBase* valid_ver)
         {
             // this used to just return the result of swapHeader, but since we
-            // want to null out the next pointer we must be more complex
+            // want to null out the next pointer we must be more complex.
+            // Once the header is released, an in-place writer may acquire
+            // valid_ver and mark it with m_next == valid_ver, so only the
+            // link to the version we replaced is cleared.
+            ObjectBase* older = valid_ver->m_next;
             bool result = swapHeader(header, set_lsb(valid_ver),
                                      unset_lsb(valid_ver));
 
-            if (result)
-                valid_ver->m_next = NULL;
+            if (result && older)
+                bool_cas(reinterpret_cast<volatile unsigned long*>
+                           (&valid_ver->m_next),
+                         reinterpret_cast<unsigned long>(older), 0);
 
             return result;
         }
@@ -1029,16 +1855,7 @@ namespace stm
 
         inline void Descriptor::removeVisibleReader(SharedBase* header) const
         {
-            // don't bother with the CAS if we're not in the bitmap
-            if (header->m_readers & id_mask) {
-                unsigned long obj_mask;
-
-                do {
-                    obj_mask = header->m_readers;
-                }
-                while (!bool_cas(&header->m_readers, obj_mask,
-                                 obj_mask & (~id_mask)));
-            }
+            header->m_readers.remove(id);
         }
 
 
@@ -1055,43 +1872,32 @@ namespace stm
 
         inline const bool Descriptor::installVisibleReader(SharedBase* header)
         {
-            if (header->m_readers & id_mask)
-                return false;
-
-            unsigned long obj_mask;
-            do {
-                obj_mask = header->m_readers;
-            } while (!bool_cas(&header->m_readers, obj_mask,
-                               obj_mask | id_mask));
-            return true;
+            return header->m_readers.install(id);
         }
 
         inline void Descriptor::abortVisibleReaders(SharedBase* header)
         {
-            unsigned long tmp_reader_bitmap = header->m_readers;
-            unsigned long desc_array_index = 0;
-
-            while (tmp_reader_bitmap) {
-                if (tmp_reader_bitmap & 1) {
-                    Descriptor* reader = desc_array[desc_array_index];
-                    // abort only if the reader exists, is ACTIVE, and isn't me
-                    if (reader && (reader != this) &&
-                        (reader->tx_state == ACTIVE))
-                    {
-                        bool_cas(&(reader->tx_state), ACTIVE, ABORTED);
+            unsigned long desc_array_index;
+            ReaderIndicator::iterator it(header->m_readers);
+
+            // only visit the set bits
+            while (it.next(desc_array_index)) {
+                Descriptor* reader = desc_array[desc_array_index];
+                // abort only if the reader exists, is ACTIVE, and isn't me
+                if (reader && (reader != this) &&
+                    (reader->tx_state == ACTIVE))
+                {
+                    bool_cas(&(reader->tx_state), ACTIVE, ABORTED);
 #ifdef USE_BIMODAL
-							reader->reschedule_core_num = iCore;
+						reader->reschedule_core_num = iCore;
 #endif	
-                    }
                 }
-
-                tmp_reader_bitmap >>= 1;
-                desc_array_index++;
             }
         }
 
-        inline const ObjectBase* Descriptor::open_RO(SharedBase* header,
-                                                     Validator& v)
+        template <bool LAZY, Descriptor::ReadRule READS>
+        inline const ObjectBase*
+        Descriptor::openReadImpl(SharedBase* header, Validator& v)
         {
             // make sure all parameters meet our expectations
             if (!header)
@@ -1103,12 +1909,31 @@ namespace stm
 
             v.config(this);
 
+#ifdef USE_BIMODAL
+            if (scheduler)
+                scheduler->noteOpen(iCore, header, false);
+
+            // no writer runs alongside a fast reader, so whatever the header
+            // points to stays current until we commit
+            if (isFastRead) {
+                ObjectBase* snap = const_cast<ObjectBase*>(header->m_payload);
+                ObjectBase* curr = get_data_ptr(snap);
+                if (is_owned(snap) && curr->m_owner->tx_state != COMMITTED)
+                    curr = curr->m_next;
+                cm.onOpenRead();
+                timing.UPDATE_TIMING(TIMING_REALWORK);
+                return curr;
+            }
+#endif
+
             // if we have a RW copy of this that we opened lazily, we must
             // return it
-            ObjectBase* ret = lookupLazyWrite(header);
-            if (ret) {
-                timing.UPDATE_TIMING(TIMING_REALWORK);
-                return ret;
+            if (LAZY) {
+                ObjectBase* ret = lookupLazyWrite(header);
+                if (ret) {
+                    timing.UPDATE_TIMING(TIMING_REALWORK);
+                    return ret;
+                }
             }
 
             while (true) {
@@ -1135,6 +1960,11 @@ namespace stm
 
                     older = newer->m_next;
 
+                    // an in-place writer owns the header a moment before it
+                    // sets m_owner and m_next; wait for it
+                    if (newer->m_inPlace && !older)
+                        continue;
+
                     owner = const_cast<Descriptor*>(newer->m_owner);
                     ownerState = owner->tx_state;
 
@@ -1144,6 +1974,18 @@ namespace stm
 
                 // if /this/ is owned, newer may not be the right ptr to use
                 if (isOwned) {
+                    // an object written in place has no older version to
+                    // fall back on
+                    if (older == newer) {
+                        if (owner == this && ownerState == ACTIVE) {
+                            cm.onReOpen();
+                            timing.UPDATE_TIMING(TIMING_REALWORK);
+                            return newer;
+                        }
+                        waitInPlace(owner, ownerState);
+                        continue;
+                    }
+
                     // if the owner is ACTIVE, either I own it or I must call
                     // CM
                     if (ownerState == ACTIVE) {
@@ -1164,7 +2006,8 @@ namespace stm
 							owner->reschedule_core_num = iCore;
 #endif				
                             timing.UPDATE_TIMING(TIMING_CM);
-                            cm.onContention();
+                            cm.onContention(&owner->tx_state,
+                                            &owner->parked);
                             verifySelf();
                             continue;
                         }
@@ -1219,7 +2062,7 @@ namespace stm
                 }
 
                 // try to be a visible reader
-                if (isVisible) {
+                if (READS == READ_VISIBLE) {
                     // install as a vis reader, and bookkeep so we can
                     // uninstall later
                     if (installVisibleReader(header))
@@ -1236,26 +2079,35 @@ namespace stm
                     // validate
                     validate();
                 }
+                else if (READS == READ_CLOCK) {
+                    // O(1), unless /newer/ was committed after our snapshot
+                    insertInvisRead(header, newer);
+                    if (newer->m_ts > start_ts)
+                        extendSnapshot();
+                }
                 else {
-                    // can cause duplicates if we don't use
-                    // addValidateInvisRead()
+                    // the index keeps out duplicates on every path
 
                     if (conflicts.shouldValidate()) {
                         if (conflicts.isValidatingInsertSafe()) {
                             validatingInsert(header, newer);
                         }
                         else {
-                            invisibleReads.insert(invis_bookkeep_t(header,
-                                                                   newer));
+                            insertInvisRead(header, newer);
                             validate();
                         }
                     }
                     else {
-                        invisibleReads.insert(invis_bookkeep_t(header, newer));
+                        insertInvisRead(header, newer);
                     }
                 }
                 verifySelf();
 
+                // reads of an object written in place are checked as they
+                // happen, against its sequence number
+                if (newer->m_inPlace)
+                    v.configInPlace(newer, newer->m_ts);
+
                 // notify cm, update read count, and return
                 cm.onOpenRead();
 
@@ -1264,8 +2116,9 @@ namespace stm
             } // end while (true)
         }
 
-        inline ObjectBase* Descriptor::open_RW(SharedBase* header,
-                                               Validator& v)
+        template <bool LAZY, Descriptor::ReadRule READS>
+        inline ObjectBase*
+        Descriptor::openWriteImpl(SharedBase* header, Validator& v)
         {
             // make sure all parameters meet our expectations
             if (!header)
@@ -1277,15 +2130,32 @@ namespace stm
 
             v.config(this);
 
+#ifdef USE_BIMODAL
+            if (scheduler)
+                scheduler->noteOpen(iCore, header, true);
+
+            // a fast reader cannot write: other fast readers may be running
+            // and none of our reads were checked. Retry as a normal
+            // transaction, which waits for the fast readers to finish.
+            if (isFastRead) {
+                scheduler->onFastReadFallback(iCore);
+                abort();
+            }
+#endif
+
             // make sure that our conflict detection strategy knows we've got a
             // write
             conflicts.onRW();
 
             // if we have an RW copy of this that we opened lazily, return it
-            ObjectBase* ret = lookupLazyWrite(header);
-            if (ret) {
-                timing.UPDATE_TIMING(TIMING_REALWORK);
-                return ret;
+            if (LAZY) {
+                ObjectBase* ret = lookupLazyWrite(header);
+                if (ret) {
+                    if (nestDepth > 1)
+                        ret = backupForLevel(header, ret, true);
+                    timing.UPDATE_TIMING(TIMING_REALWORK);
+                    return ret;
+                }
             }
 
             while (true) {
@@ -1310,6 +2180,11 @@ namespace stm
 
                     older = newer->m_next;
 
+                    // an in-place writer owns the header a moment before it
+                    // sets m_owner and m_next; wait for it
+                    if (newer->m_inPlace && !older)
+                        continue;
+
                     owner = const_cast<Descriptor*>(newer->m_owner);
                     ownerState = owner->tx_state;
 
@@ -1319,11 +2194,25 @@ namespace stm
 
                 // if /this/ is owned, curr_version may not be right
                 if (isOwned) {
+                    // an object written in place has no older version to
+                    // fall back on
+                    if (older == newer) {
+                        if (owner == this && ownerState == ACTIVE) {
+                            cm.onReOpen();
+                            timing.UPDATE_TIMING(TIMING_REALWORK);
+                            return newer;
+                        }
+                        waitInPlace(owner, ownerState);
+                        continue;
+                    }
+
                     // if the owner is ACTIVE, either I own it or I must call
                     // CM
                     if (ownerState == ACTIVE) {
                         if (owner == this) {
                             cm.onReOpen();
+                            if (nestDepth > 1)
+                                newer = backupForLevel(header, newer, false);
                             timing.UPDATE_TIMING(TIMING_REALWORK);
                             return newer;
                         }
@@ -1339,7 +2228,8 @@ namespace stm
 							owner->reschedule_core_num = iCore;
 #endif	
                             timing.UPDATE_TIMING(TIMING_CM);
-                            cm.onContention();
+                            cm.onContention(&owner->tx_state,
+                                            &owner->parked);
                             verifySelf();
                             continue;
                         }
@@ -1356,7 +2246,7 @@ namespace stm
                     // if current owner is aborted use cleanOnAbort if we are
                     // lazy, else just plan on using older
                     if (ownerState == ABORTED) {
-                        if (isLazy) {
+                        if (LAZY) {
                             // if lazy, we must clean header:
                             if (!cleanOnAbort(header, snap, older)) {
                                 // cleanup failed; if snap != older there is
@@ -1381,7 +2271,7 @@ namespace stm
                     else {
                         // we had better be looking at a committed object
                         assert(ownerState == COMMITTED);
-                        if (isLazy) {
+                        if (LAZY) {
                             // if lazy, we must clean header:
                             if (!cleanOnCommit(header, newer)) {
                                 // cleanOnCommit failed; if payload != newer
@@ -1399,8 +2289,11 @@ namespace stm
                     }
                 }
 
-                // EAGER: continue if we can't abort all visible readers
-                if (!isLazy && !cm.shouldAbortAll(header->m_readers)) {
+                // EAGER or IN PLACE: continue if we can't abort all visible
+                // readers
+                if ((!LAZY || newer->m_inPlace)
+                    && !cm.shouldAbortAll(header->m_readers))
+                {
                     timing.UPDATE_TIMING(TIMING_CM);
                     cm.onContention();
                     verifySelf();
@@ -1408,16 +2301,52 @@ namespace stm
                 }
 
 
+                // IN PLACE: acquire the current version itself, eagerly even
+                // in a lazy tx, since nobody may copy it while we own it.
+                // Its setters log what they overwrite while m_next points to
+                // it.
+                if (newer->m_inPlace) {
+                    if (!swapHeader(header, snap, set_lsb(newer))) {
+                        ConflictCounter[id].ADD_CLEANUP_FAIL();
+                        timing.UPDATE_TIMING(TIMING_CM);
+                        cm.onContention();
+                        verifySelf();
+                        continue;
+                    }
+                    newer->m_owner = this;
+                    cfence();
+                    newer->m_next = newer;
+                    cfence();
+
+                    abortVisibleReaders(header);
+                    eagerWrites.insert(eager_bookkeep_t(header, newer, newer));
+                    ConflictCounter[id].ADD_IN_PLACE();
+
+                    if (conflicts.shouldValidate())
+                        validate();
+                    verifySelf();
+                    cm.onOpenWrite();
+                    timing.UPDATE_TIMING(TIMING_REALWORK);
+                    return newer;
+                }
+
                 // clone the object and make me the owner of the new version
                 timing.UPDATE_TIMING(TIMING_COPY);
                 ObjectBase* new_version = newer->clone();
                 assert(new_version);
+                ConflictCounter[id].ADD_CLONE();
                 new_version->m_st = header;
                 new_version->m_next = newer;
                 new_version->m_owner = this;
+#ifdef MULTI_VERSION
+                // clone() may copy these; the new version has no commit time
+                // yet, and /newer/ is what it replaces
+                new_version->m_ts = 0;
+                new_version->m_older = newer;
+#endif
                 timing.UPDATE_TIMING(TIMING_BOOKKEEPING);
 
-                if (isLazy) {
+                if (LAZY) {
                     // LAZY: just add /this/ to my lazy writeset and mark the
                     // old version for delete on commit
                     lazyWrites.insert(lazy_bookkeep_t(header, newer, new_version));
@@ -1446,7 +2375,11 @@ namespace stm
                 }
 
                 // Validate, notify cm, reset timing, and return
-                if (conflicts.shouldValidate())
+                if (READS == READ_CLOCK) {
+                    if (newer->m_ts > start_ts)
+                        extendSnapshot();
+                }
+                else if (conflicts.shouldValidate())
                     validate();
 
                 verifySelf();
@@ -1456,6 +2389,361 @@ namespace stm
             } // end while (true)
         }
 
+        inline void Descriptor::beginNested()
+        {
+            nest_checkpoint_t cp;
+            cp.invisibleReads = invisibleReads.element_count;
+            cp.eagerWrites = eagerWrites.element_count;
+            cp.lazyWrites = lazyWrites.element_count;
+            cp.undoLog = undoLog.element_count;
+            cp.backups = nestBackups.element_count;
+            cp.deleteOnCommit = mm.deleteOnCommit.element_count;
+            cp.deleteOnAbort = mm.deleteOnAbort.element_count;
+            nestLevels.insert(cp);
+            nestDepth++;
+
+            // cleanupNested() pops the level even if we are already dead
+            verifySelf();
+        }
+
+        inline bool Descriptor::cleanupNested()
+        {
+            nest_checkpoint_t cp =
+                nestLevels.elements[nestLevels.element_count - 1];
+            nestLevels.element_count--;
+            nestDepth--;
+
+            // committed: the logs now belong to the parent
+            if (tx_state == ACTIVE && !partialAbort)
+                return true;
+
+            // partial abort: retry this level, unless we are told to stop
+            if (tx_state == ACTIVE && !stm::terminate) {
+                timing.UPDATE_TIMING(TIMING_BOOKKEEPING);
+                rollbackTo(cp);
+                partialAbort = false;
+                ConflictCounter[id].ADD_PARTIAL_ABORT();
+                timing.UPDATE_TIMING(TIMING_REALWORK);
+                return false;
+            }
+
+            // the parent can't go on; let its END_TRANSACTION clean up
+            partialAbort = false;
+            tx_state = ABORTED;
+            unwind();
+            return false;
+        }
+
+        inline bool Descriptor::outerLevelsValid() const
+        {
+            const nest_checkpoint_t& cp =
+                nestLevels.elements[nestLevels.element_count - 1];
+
+            // remove() may have pulled an inner read below the checkpoint;
+            // checking it too is merely conservative
+            unsigned long reads = cp.invisibleReads;
+            if (reads > invisibleReads.element_count)
+                reads = invisibleReads.element_count;
+            for (unsigned long i = 0; i < reads; i++)
+                if (!isCurrentRead(invisibleReads.elements[i]))
+                    return false;
+
+            for (unsigned long i = 0; i < cp.lazyWrites; i++)
+                if (!isCurrent(lazyWrites.elements[i].shared,
+                               lazyWrites.elements[i].read_version))
+                    return false;
+            return true;
+        }
+
+        inline void Descriptor::rollbackTo(const nest_checkpoint_t& cp)
+        {
+            // outer versions this level copied become current again
+            for (unsigned long i = nestBackups.element_count;
+                 i > cp.backups; i--)
+            {
+                nest_backup_t& b = nestBackups.elements[i - 1];
+                if (b.lazy) {
+                    lazyWrites.elements[b.index].write_version = b.saved;
+                }
+                else {
+                    // only we change the header of an object we own
+                    swapHeader(b.shared, set_lsb(b.copy), set_lsb(b.saved));
+                    eagerWrites.elements[b.index].write_version = b.saved;
+                }
+            }
+            nestBackups.element_count = cp.backups;
+
+            // in-place bytes first, then let go of what this level acquired
+            restoreUndoLog(cp.undoLog);
+            undoLog.element_count = cp.undoLog;
+
+            eager_bookkeep_t* e = eagerWrites.elements;
+            for (unsigned long i = cp.eagerWrites;
+                 i < eagerWrites.element_count; i++)
+            {
+                if (e[i].write_version == e[i].read_version)
+                    releaseInPlace(e[i].shared, e[i].write_version, false);
+                else
+                    cleanOnAbort(e[i].shared, e[i].write_version,
+                                 e[i].read_version);
+            }
+            eagerWrites.element_count = cp.eagerWrites;
+
+            // lazy clones were never published
+            lazyWrites.element_count = cp.lazyWrites;
+
+            // the read index checks positions, so it survives the cut
+            if (invisibleReads.element_count > cp.invisibleReads)
+                invisibleReads.element_count = cp.invisibleReads;
+
+            // visible reads stay installed until the top level ends, which
+            // can only cause extra conflicts
+            mm.rollbackTo(cp.deleteOnCommit, cp.deleteOnAbort);
+        }
+
+        inline ObjectBase* Descriptor::backupForLevel(SharedBase* header,
+                                                      ObjectBase* version,
+                                                      bool lazy)
+        {
+            const nest_checkpoint_t& cp =
+                nestLevels.elements[nestLevels.element_count - 1];
+
+            // a version this level made is thrown away whole on rollback
+            for (unsigned long i = cp.backups;
+                 i < nestBackups.element_count; i++)
+                if (nestBackups.elements[i].copy == version)
+                    return version;
+
+            unsigned long index;
+            if (lazy) {
+                for (index = 0; index < lazyWrites.element_count; index++)
+                    if (lazyWrites.elements[index].shared == header)
+                        break;
+                if (index >= cp.lazyWrites)
+                    return version;
+            }
+            else {
+                for (index = 0; index < eagerWrites.element_count; index++)
+                    if (eagerWrites.elements[index].shared == header)
+                        break;
+                if (index >= cp.eagerWrites)
+                    return version;
+            }
+
+            timing.UPDATE_TIMING(TIMING_COPY);
+            ObjectBase* copy = version->clone();
+            assert(copy);
+            ConflictCounter[id].ADD_CLONE();
+            copy->m_st = header;
+            copy->m_next = version->m_next;
+            copy->m_owner = this;
+#ifdef MULTI_VERSION
+            copy->m_ts = 0;
+            copy->m_older = version->m_older;
+#endif
+            timing.UPDATE_TIMING(TIMING_BOOKKEEPING);
+
+            if (lazy) {
+                lazyWrites.elements[index].write_version = copy;
+            }
+            else {
+                // readers go through the header to copy->m_next, which is
+                // the same version they used before
+                if (!swapHeader(header, set_lsb(version), set_lsb(copy))) {
+                    // someone aborted us and cleaned up the object
+                    verifySelf();
+                    assert(false);
+                }
+                eagerWrites.elements[index].write_version = copy;
+            }
+            nestBackups.insert(nest_backup_t(header, version, copy, index,
+                                             lazy));
+
+            // /version/ is garbage once the top level commits; /copy/ was
+            // logged for abort when we allocated it
+            mm.deleteOnCommit.insert(version);
+            return copy;
+        }
+
+        inline void Descriptor::commitIrrevocable()
+        {
+            // nobody else is running, so nobody can have aborted us
+            timing.UPDATE_TIMING(TIMING_BOOKKEEPING);
+            tx_state = COMMITTED;
+            cm.onTxCommitted();
+        }
+
+        inline const ObjectBase*
+        Descriptor::openReadIrrevocable(SharedBase* header, Validator& v)
+        {
+            if (!header)
+                return NULL;
+
+            v.config(this);
+
+            // every other transaction has cleaned up, so the header is clean
+            // and stays that way until we are done
+            ObjectBase* snap = const_cast<ObjectBase*>(header->m_payload);
+            assert(!is_owned(snap));
+            cm.onOpenRead();
+            return get_data_ptr(snap);
+        }
+
+        inline ObjectBase*
+        Descriptor::openWriteIrrevocable(SharedBase* header, Validator& v)
+        {
+            if (!header)
+                return NULL;
+
+            v.config(this);
+            conflicts.onRW();
+
+            // no one can see the object before we are done with it, and we
+            // never roll back, so write the current version in place
+            ObjectBase* snap = const_cast<ObjectBase*>(header->m_payload);
+            assert(!is_owned(snap));
+            cm.onOpenWrite();
+            return get_data_ptr(snap);
+        }
+
+        inline void Descriptor::commitReadOnly()
+        {
+            timing.UPDATE_TIMING(TIMING_BOOKKEEPING);
+
+            if (tx_state != ACTIVE)
+                return;
+            cm.onTryCommitTx();
+
+            // a clock reader's snapshot is consistent as it stands, and a
+            // fast reader has nothing to check
+            bool validate = !isClock();
+#ifdef USE_BIMODAL
+            validate = validate && !isFastRead;
+#endif
+            if (validate && !conflicts.tryCommit()) {
+                timing.UPDATE_TIMING(TIMING_VALIDATION);
+                verifyInvisReads();
+                conflicts.forceCommit();
+            }
+
+            // we published nothing, so no one waits on our state to see our
+            // writes.  Writers abort visible readers before writing, so if
+            // we are still ACTIVE here our reads were all current now, and
+            // an abort that lands after this check can't change what we
+            // read: a plain store will do.
+            if (tx_state == ACTIVE)
+                tx_state = COMMITTED;
+        }
+
+#ifdef MULTI_VERSION
+        inline const ObjectBase*
+        Descriptor::openReadSnapshot(SharedBase* header, Validator& v)
+        {
+            if (!header)
+                return NULL;
+
+            timing.UPDATE_TIMING(TIMING_BOOKKEEPING);
+            verifySelf();
+            v.config(this);
+
+            // find the committed version behind the header, without
+            // cleaning it up or calling the CM
+            ObjectBase* ver;
+            while (true) {
+                ObjectBase* snap = const_cast<ObjectBase*>(header->m_payload);
+                ver = get_data_ptr(snap);
+                if (!is_owned(snap))
+                    break;
+
+                Descriptor* owner = const_cast<Descriptor*>(ver->m_owner);
+                unsigned long ownerState = owner->tx_state;
+                unsigned long ts = ver->m_ts;
+                ObjectBase* older = ver->m_next;
+                if (header->m_payload != snap)
+                    continue;
+
+                if (ownerState == COMMITTED)
+                    break;
+
+                // an owner that has not started to take its commit time
+                // will take one after our snapshot
+                if (ownerState == ABORTED || ts == 0
+                    || (ts != TS_PENDING && ts > start_ts))
+                {
+                    ver = older;
+                    break;
+                }
+
+                // the owner is committing, maybe inside our snapshot; it
+                // will be done in a moment
+                spin_pause();
+            }
+
+            // go back to the version that was current at start_ts.  Only a
+            // commit stamps a version, and it links the version it replaced,
+            // so a version newer than our snapshot always has an older one.
+            // Every version we pass was replaced after our snapshot was
+            // taken, so the Reclaimer can't have freed the next one yet.
+            while (ver->m_ts > start_ts) {
+                ver = ver->m_older;
+                assert(ver);
+                ConflictCounter[id].ADD_OLD_VERSION();
+            }
+
+            cm.onOpenRead();
+            timing.UPDATE_TIMING(TIMING_REALWORK);
+            return ver;
+        }
+#endif
+
+/**
+ *  Call the instantiation of FN that matches the transaction's mode
+ */
+#define RSTM_MODE_DISPATCH(FN, IRREVOCABLE_FN, ARGS)                   \
+        switch (mode) {                                                 \
+          case MODE_VIS_EAGER:   return FN<false, READ_VISIBLE> ARGS;   \
+          case MODE_VIS_LAZY:    return FN<true, READ_VISIBLE> ARGS;    \
+          case MODE_INVIS_EAGER: return FN<false, READ_INVISIBLE> ARGS; \
+          case MODE_INVIS_LAZY:  return FN<true, READ_INVISIBLE> ARGS;  \
+          case MODE_CLOCK_EAGER: return FN<false, READ_CLOCK> ARGS;     \
+          case MODE_CLOCK_LAZY:  return FN<true, READ_CLOCK> ARGS;      \
+          default:               return IRREVOCABLE_FN ARGS;            \
+        }
+
+        inline void Descriptor::commit()
+        {
+            // a nested level commits into its parent, in cleanupNested()
+            if (nestDepth > 1) {
+                verifySelf();
+                return;
+            }
+            if (readOnly && mode != MODE_IRREVOCABLE) {
+                commitReadOnly();
+                return;
+            }
+            RSTM_MODE_DISPATCH(commitImpl, commitIrrevocable, ());
+        }
+
+        inline const ObjectBase* Descriptor::open_RO(SharedBase* header,
+                                                     Validator& v)
+        {
+#ifdef MULTI_VERSION
+            if (readOnly && isClock())
+                return openReadSnapshot(header, v);
+#endif
+            RSTM_MODE_DISPATCH(openReadImpl, openReadIrrevocable, (header, v));
+        }
+
+        inline ObjectBase* Descriptor::open_RW(SharedBase* header,
+                                               Validator& v)
+        {
+            assert(!readOnly);
+            RSTM_MODE_DISPATCH(openWriteImpl, openWriteIrrevocable,
+                               (header, v));
+        }
+
+#undef RSTM_MODE_DISPATCH
+
         inline ObjectBase* Descriptor::open_un(SharedBase* header)
         {
 #ifdef PRIVATIZATION_TFENCE
@@ -1496,6 +2784,11 @@ namespace stm
 
                     older = newer->m_next;
 
+                    // an in-place writer owns the header a moment before it
+                    // sets m_owner and m_next; wait for it
+                    if (!older)
+                        continue;
+
                     owner = const_cast<Descriptor*>(newer->m_owner);
                     ownerState = owner->tx_state;
 
@@ -1505,6 +2798,14 @@ namespace stm
 
                 // if /this/ is owned, newer may not be the right ptr to use
                 if (isOwned) {
+                    // an object written in place is restored and released by
+                    // its owner, never by us
+                    if (older == newer) {
+                        if (ownerState == ACTIVE)
+                            bool_cas(&(owner->tx_state), ACTIVE, ABORTED);
+                        continue;
+                    }
+
                     // if the owner is ACTIVE, abort him
                     if (ownerState == ACTIVE) {
                         // if abort fails, restart loop
@@ -1567,7 +2868,7 @@ namespace stm
             // that's orthogonal to whether it's in my read set
 
             // branch based on whether this is a visible read or not
-            if ((obj->m_readers & id_mask) != 0) {
+            if (obj->m_readers.contains(id)) {
                 // I'm a vis reader: remove self from the visible reader bitmap
                 // and remove /this/ from my vis read set
                 removeVisibleReader(obj);
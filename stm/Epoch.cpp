@@ -88,3 +88,18 @@ void stm::Epoch::waitForDominatingEpoch()
     // timestamp.
     stm::mm::txfree(ts);
 }
+
+void stm::Epoch::waitForQuiescence(unsigned long self)
+{
+    // threads that register after this point find new transactions held off
+    unsigned long numThreads = stm::idManager.getThreadCount();
+
+    for (unsigned long i = 0; i < numThreads; i++) {
+        if (i == self)
+            continue;
+        // an odd entry means the thread is still in a transaction
+        while (*(volatile unsigned long*)&trans_nums[i*16] & 1)
+            for (int j = 0; j < 128; j++)
+                nop();
+    }
+}
@@ -124,6 +124,12 @@ namespace stm
          */
         void waitForDominatingEpoch();
 
+        /**
+         *  Block until no thread other than /self/ is inside a transaction.
+         *  The caller must keep new transactions from starting.
+         */
+        void waitForQuiescence(unsigned long self);
+
     } __attribute__ ((aligned(64))) ;
 
     /**
@@ -128,7 +128,31 @@ namespace stm
         {
             // get an id for this thread
             unsigned long id = fai(&activeThreads);
+            setThreadId(id);
+            // return the ID
+            return id;
+        }
+
+        /**
+         *  Make the calling thread act under an id that was registered by
+         *  another thread, and return the id it had before.  The owner of
+         *  the id must not run transactions until the id is handed back.
+         *  This is how the BiModal scheduler lets a submitting thread run a
+         *  job inline under a runner's identity.
+         */
+        unsigned long adoptThreadId(unsigned long id)
+        {
+            unsigned long old = getThreadId();
+            setThreadId(id);
+            return old;
+        }
 
+      private:
+        /**
+         *  Store an id in whatever method of TLS we're using.
+         */
+        void setThreadId(unsigned long id)
+        {
 #if defined(TLS_GCC_IMPLICIT)
             // store the id in the gcc thread-local static var
             s_tid = id;
@@ -146,8 +170,6 @@ namespace stm
             // something is wrong
             abort();
 #endif
-            // return the ID
-            return id;
         }
     } __attribute__ ((aligned(64)));
 
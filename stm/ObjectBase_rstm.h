@@ -79,11 +79,59 @@ namespace stm
              */
             SharedBase* m_st;
 
+            /**
+             *  Global clock time at which the transaction that created /this/
+             *  committed.  Only maintained in clock validation modes; 0 for
+             *  versions that no such transaction wrote.  In the other modes,
+             *  objects written in place use it as a sequence number.
+             */
+            volatile unsigned long m_ts;
+
+            /**
+             *  True if eager writers update /this/ in place, logging what they
+             *  overwrite, instead of cloning it.  Set by InPlaceObject<T>.
+             *  While a writer holds such an object, m_next points to the
+             *  object itself.
+             */
+            bool m_inPlace;
+
+            /**
+             *  True if a reader whose version was replaced may keep going
+             *  as long as the current version has the same value (see
+             *  sameValue).  Set by ValueValidatedObject<T>.
+             */
+            bool m_byValue;
+
+#ifdef MULTI_VERSION
+            /**
+             *  The version that /this/ replaced when its writer committed,
+             *  so that snapshot readers can go back in time.  Only followed
+             *  while m_ts is newer than the reader's snapshot, and a version
+             *  older than any running snapshot may already be reclaimed.
+             */
+            ObjectBase* m_older;
+#endif
+
             /**
              *  Ctor: zeros out all fields.  Note that we never make ObjectBase
              *  objects directly, only through Object<T>.
              */
-            ObjectBase() : m_next(NULL), m_owner(NULL), m_st(NULL) { }
+            ObjectBase()
+                : m_next(NULL), m_owner(NULL), m_st(NULL), m_ts(0),
+                  m_inPlace(false), m_byValue(false)
+#ifdef MULTI_VERSION
+                , m_older(NULL)
+#endif
+            { }
+
+            /**
+             *  True if /other/, another version of the same object, holds
+             *  the same value as /this/.  Only called when m_byValue is set.
+             */
+            virtual bool sameValue(const ObjectBase* other) const
+            {
+                return false;
+            }
 
             /**
              *  The user must provide clone, which is a tx-safe copy of the
@@ -69,6 +69,12 @@ namespace stm
             if (!this)
                 return NULL;
 
+#ifdef OREC_TABLE
+            // a redo log knows its shared object
+            SharedBase* retval = m_master ? m_master
+                                          : const_cast<Object<T>*>(this);
+            return static_cast<internal::Shared<T>*>(retval);
+#else
             // get a snapshot of the header
             internal::metadata_dword_t snap;
             snap.dword = m_metadata.dword;
@@ -88,9 +94,28 @@ namespace stm
 
             // put the type-ness on retval and return it
             return static_cast<internal::Shared<T>*>(retval);
+#endif
         }
 
     };
+
+    /**
+     *  redo_lock always writes to a redo log, so objects that ask to be
+     *  written in place need no undo logging.
+     */
+    template <class T>
+    class InPlaceObject : public Object<T>
+    {
+      protected:
+        void logUndo(void* addr, size_t len) { }
+    };
+
+    /**
+     *  redo_lock validates reads by version number only, so objects that
+     *  ask to be validated by value are plain objects.
+     */
+    template <class T>
+    class ValueValidatedObject : public Object<T> { };
 } // namespace stm
 
 #endif // __OBJECT_H__
@@ -84,6 +84,58 @@ namespace stm
                 (static_cast<volatile internal::Shared<T>*>(m_st));
         }
     };
+
+    /**
+     *  Classes that derive from InPlaceObject<T> rather than Object<T> are
+     *  not cloned by eager, incrementally validated transactions.  The writer
+     *  acquires the object itself, its setters log the bytes they overwrite,
+     *  and the log is written back if the writer aborts.  All fields must be
+     *  declared with GENERATE_UNDO_FIELD / GENERATE_UNDO_ARRAY so that the
+     *  setters log.  Without IN_PLACE_WRITES this is just Object<T>.
+     */
+    template <class T>
+    class InPlaceObject : public Object<T>
+    {
+      protected:
+        InPlaceObject()
+        {
+#ifdef IN_PLACE_WRITES
+            this->m_inPlace = true;
+#endif
+        }
+
+        /**
+         *  Called by the setters before they overwrite a field.  Only the
+         *  owner has a writable pointer while m_next points to /this/.
+         */
+        void logUndo(void* addr, size_t len)
+        {
+            if (this->m_next == this)
+                this->m_owner->logUndo(addr, len);
+        }
+    };
+
+    /**
+     *  Classes that derive from ValueValidatedObject<T> are validated by
+     *  value when read invisibly: if a writer replaced the version we read
+     *  with one whose fields compare equal (a write of the same value, or
+     *  an insert and remove that put things back), the reader does not
+     *  abort.  T must provide operator==.  Meant for small, hot objects
+     *  that are rarely changed for real; the comparison only runs once the
+     *  version check has already failed.
+     */
+    template <class T>
+    class ValueValidatedObject : public Object<T>
+    {
+      protected:
+        ValueValidatedObject() { this->m_byValue = true; }
+
+        virtual bool sameValue(const internal::ObjectBase* other) const
+        {
+            return *static_cast<const T*>(this)
+                == *static_cast<const T*>(other);
+        }
+    };
 } // stm
 
 #endif // __OBJECT_H__
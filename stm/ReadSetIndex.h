@@ -0,0 +1,175 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2005, 2006
+// University of Rochester
+// Department of Computer Science
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//    * Redistributions of source code must retain the above copyright notice,
+//      this list of conditions and the following disclaimer.
+//
+//    * Redistributions in binary form must reproduce the above copyright
+//      notice, this list of conditions and the following disclaimer in the
+//      documentation and/or other materials provided with the distribution.
+//
+//    * Neither the name of the University of Rochester nor the names of its
+//      contributors may be used to endorse or promote products derived from
+//      this software without specific prior written permission.
+//
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef __READSETINDEX_H__
+#define __READSETINDEX_H__
+
+#include <cassert>
+#include <cstring>
+#include "stm_mm.h"
+
+namespace stm
+{
+    /**
+     *  Open-addressed hash index from an object header to its position in a
+     *  read set (a MiniVector), so that finding duplicates does not require
+     *  walking the whole set.
+     *
+     *  The index never deletes anything.  Instead, every slot is stamped with
+     *  the generation it was written in, so that reset() is O(1), and a hit
+     *  only gives a candidate position: the caller must check that the read
+     *  set still holds the same key at that position.  That check also keeps
+     *  the index right when the read set is truncated or reordered behind
+     *  its back.
+     */
+    class ReadSetIndex
+    {
+        struct slot_t
+        {
+            const void* key;
+            unsigned long pos;
+            unsigned long gen;
+        };
+
+        /**
+         *  Cache the thread-local allocator
+         */
+        stm::mm::TxHeap* heap;
+
+        /**
+         *  The table, its size minus one (sizes are powers of two), and the
+         *  number of slots written in the current generation
+         */
+        slot_t* slots;
+        unsigned long mask;
+        unsigned long count;
+
+        /**
+         *  Slots stamped with an older generation are empty
+         */
+        unsigned long gen;
+
+        static unsigned long hash(const void* key)
+        {
+            unsigned long h = reinterpret_cast<unsigned long>(key) >> 3;
+            h ^= h >> 16;
+            h *= 0x45d9f3bUL;
+            h ^= h >> 16;
+            return h;
+        }
+
+        slot_t* alloc(unsigned long size)
+        {
+            slot_t* s =
+                reinterpret_cast<slot_t*>(heap->tx_alloc(sizeof(slot_t) * size));
+            assert(s);
+            memset(s, 0, sizeof(slot_t) * size);
+            return s;
+        }
+
+        /**
+         *  Double the table, carrying over the slots of this generation
+         */
+        void grow()
+        {
+            slot_t* old_slots = slots;
+            unsigned long old_size = mask + 1;
+            mask = (old_size << 1) - 1;
+            slots = alloc(mask + 1);
+            count = 0;
+            for (unsigned long i = 0; i < old_size; i++)
+                if (old_slots[i].gen == gen)
+                    insert(old_slots[i].key, old_slots[i].pos);
+            heap->tx_free(old_slots);
+        }
+
+      public:
+        ReadSetIndex(stm::mm::TxHeap* h, unsigned long initial_size)
+            : heap(h), mask(initial_size - 1), count(0), gen(1)
+        {
+            assert((initial_size & mask) == 0);
+            slots = alloc(initial_size);
+        }
+
+        /**
+         *  Forget every entry
+         */
+        void reset()
+        {
+            count = 0;
+            // on wraparound, old stamps could look current again
+            if (++gen == 0) {
+                memset(slots, 0, sizeof(slot_t) * (mask + 1));
+                gen = 1;
+            }
+        }
+
+        /**
+         *  If /key/ was recorded in this generation, put its last recorded
+         *  position in /pos/ and return true
+         */
+        bool lookup(const void* key, unsigned long& pos) const
+        {
+            for (unsigned long i = hash(key) & mask; ; i = (i + 1) & mask) {
+                if (slots[i].gen != gen)
+                    return false;
+                if (slots[i].key == key) {
+                    pos = slots[i].pos;
+                    return true;
+                }
+            }
+        }
+
+        /**
+         *  Record /key/ at /pos/, replacing any older position of /key/
+         */
+        void insert(const void* key, unsigned long pos)
+        {
+            unsigned long i = hash(key) & mask;
+            while (slots[i].gen == gen && slots[i].key != key)
+                i = (i + 1) & mask;
+            if (slots[i].gen != gen) {
+                slots[i].key = key;
+                slots[i].gen = gen;
+                count++;
+            }
+            slots[i].pos = pos;
+            // keep the load under 1/2 so probe sequences stay short
+            if (count * 2 > mask)
+                grow();
+        }
+    };
+}
+
+#endif // __READSETINDEX_H__
@@ -0,0 +1,287 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2005, 2006
+// University of Rochester
+// Department of Computer Science
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//    * Redistributions of source code must retain the above copyright notice,
+//      this list of conditions and the following disclaimer.
+//
+//    * Redistributions in binary form must reproduce the above copyright
+//      notice, this list of conditions and the following disclaimer in the
+//      documentation and/or other materials provided with the distribution.
+//
+//    * Neither the name of the University of Rochester nor the names of its
+//      contributors may be used to endorse or promote products derived from
+//      this software without specific prior written permission.
+//
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef __READERINDICATOR_H__
+#define __READERINDICATOR_H__
+
+#include <cassert>
+#include <cstdlib>
+#include "atomic_ops.h"
+#include "stm_common.h"
+
+/**
+ *  A ReaderIndicator is the set of visible readers of an object, identified
+ *  by thread id.  Writers enumerate it to abort its members, possibly after
+ *  asking their contention manager.  Both versions below have the same
+ *  interface; SCALABLE_READERS picks the second one.
+ */
+
+#ifndef SCALABLE_READERS
+
+namespace stm
+{
+    namespace internal
+    {
+        /**
+         *  The original indicator: one bitmap word, so only threads 0..31 can
+         *  be visible readers, and every reader CASes the same word.
+         */
+        class ReaderIndicator
+        {
+            volatile unsigned long bits;
+
+          public:
+            ReaderIndicator() : bits(0) { }
+
+            /**
+             *  True if thread /id/ can read visibly at all
+             */
+            static bool supports(unsigned long id) { return id < 32; }
+
+            bool contains(unsigned long id) const
+            {
+                return bits & (1UL << id);
+            }
+
+            /**
+             *  Add /id/ to the set.  Returns false if it was already there.
+             */
+            bool install(unsigned long id)
+            {
+                unsigned long mask = 1UL << id;
+                if (bits & mask)
+                    return false;
+
+                unsigned long old;
+                do {
+                    old = bits;
+                } while (!bool_cas(&bits, old, old | mask));
+                return true;
+            }
+
+            void remove(unsigned long id)
+            {
+                unsigned long mask = 1UL << id;
+                // don't bother with the CAS if we're not in the bitmap
+                if (!(bits & mask))
+                    return;
+
+                unsigned long old;
+                do {
+                    old = bits;
+                } while (!bool_cas(&bits, old, old & ~mask));
+            }
+
+            bool empty() const { return bits == 0; }
+
+            /**
+             *  Walks a snapshot of the readers
+             */
+            class iterator
+            {
+                unsigned long snap;
+
+              public:
+                iterator(const ReaderIndicator& r) : snap(r.bits) { }
+
+                bool next(unsigned long& id)
+                {
+                    if (!snap)
+                        return false;
+                    id = __builtin_ctzl(snap);
+                    snap &= snap - 1;
+                    return true;
+                }
+            };
+        };
+    }
+}
+
+#else // SCALABLE_READERS
+
+/**
+ *  Readers are spread over this many words, each on its own cache line
+ */
+#define READER_GROUPS 8
+#define READER_LINE_SIZE 64
+
+namespace stm
+{
+    namespace internal
+    {
+        /**
+         *  Indicator for up to MAX_THREADS readers.  Thread /id/ owns bit
+         *  id / READER_GROUPS of group id % READER_GROUPS, so that threads
+         *  with consecutive ids CAS different cache lines.  The groups are
+         *  only allocated once someone reads the object visibly, and a
+         *  sticky summary word tells writers which groups ever had a reader,
+         *  so that they skip the rest without touching their lines.
+         */
+        class ReaderIndicator
+        {
+            struct group_t
+            {
+                volatile unsigned long bits;
+                char pad[READER_LINE_SIZE - sizeof(unsigned long)];
+            };
+
+            static const unsigned long GROUP_BITS = sizeof(unsigned long) * 8;
+
+            /**
+             *  Bit g is set once group g has had a reader; never cleared
+             */
+            volatile unsigned long summary;
+
+            group_t* volatile groups;
+
+            static unsigned long group(unsigned long id)
+            {
+                return id % READER_GROUPS;
+            }
+
+            static unsigned long mask(unsigned long id)
+            {
+                return 1UL << (id / READER_GROUPS);
+            }
+
+            /**
+             *  Allocate the groups on first use; the loser of a race frees
+             *  its copy
+             */
+            group_t* getGroups()
+            {
+                if (groups)
+                    return groups;
+
+                void* mem;
+                if (posix_memalign(&mem, READER_LINE_SIZE,
+                                   sizeof(group_t) * READER_GROUPS))
+                    std::abort();
+                group_t* g = static_cast<group_t*>(mem);
+                for (int i = 0; i < READER_GROUPS; i++)
+                    g[i].bits = 0;
+
+                if (!bool_cas(reinterpret_cast<volatile unsigned long*>
+                                (&groups),
+                              0, reinterpret_cast<unsigned long>(g)))
+                    free(g);
+                return groups;
+            }
+
+          public:
+            ReaderIndicator() : summary(0), groups(NULL) { }
+
+            ~ReaderIndicator() { free(groups); }
+
+            static bool supports(unsigned long id)
+            {
+                return id < READER_GROUPS * GROUP_BITS;
+            }
+
+            bool contains(unsigned long id) const
+            {
+                return (summary & (1UL << group(id)))
+                    && (groups[group(id)].bits & mask(id));
+            }
+
+            bool install(unsigned long id)
+            {
+                volatile unsigned long* word = &getGroups()[group(id)].bits;
+                unsigned long m = mask(id);
+                if (*word & m)
+                    return false;
+
+                unsigned long old;
+                do {
+                    old = *word;
+                } while (!bool_cas(word, old, old | m));
+
+                // publish the group, unless a reader already did
+                unsigned long s = 1UL << group(id);
+                while (!(summary & s)) {
+                    old = summary;
+                    bool_cas(&summary, old, old | s);
+                }
+                return true;
+            }
+
+            void remove(unsigned long id)
+            {
+                if (!contains(id))
+                    return;
+
+                volatile unsigned long* word = &groups[group(id)].bits;
+                unsigned long m = mask(id);
+                unsigned long old;
+                do {
+                    old = *word;
+                } while (!bool_cas(word, old, old & ~m));
+            }
+
+
+            /**
+             *  Walks the readers, one group word at a time
+             */
+            class iterator
+            {
+                const ReaderIndicator& r;
+                unsigned long groupsLeft;
+                unsigned long g;
+                unsigned long snap;
+
+              public:
+                iterator(const ReaderIndicator& _r)
+                    : r(_r), groupsLeft(_r.summary), g(0), snap(0) { }
+
+                bool next(unsigned long& id)
+                {
+                    while (!snap) {
+                        if (!groupsLeft)
+                            return false;
+                        g = __builtin_ctzl(groupsLeft);
+                        groupsLeft &= groupsLeft - 1;
+                        snap = r.groups[g].bits;
+                    }
+                    id = __builtin_ctzl(snap) * READER_GROUPS + g;
+                    snap &= snap - 1;
+                    return true;
+                }
+            };
+        };
+    }
+}
+
+#endif // SCALABLE_READERS
+
+#endif // __READERINDICATOR_H__
@@ -111,12 +111,19 @@ namespace stm
          */
         stm::mm::TxHeap* heap;
 
+        /**
+         *  Objects added but not yet deleted, and the most there ever were
+         */
+        unsigned long pending;
+        unsigned long peak;
+
       public:
         /**
          *  Construct a reclaimer by giving it a heap and allocating a prelimbo
          *  node.
          */
-        Reclaimer(stm::mm::TxHeap* gcd) : limbo(NULL), heap(gcd)
+        Reclaimer(stm::mm::TxHeap* gcd)
+            : limbo(NULL), heap(gcd), pending(0), peak(0)
         {
             prelimbo = new (heap->tx_alloc(sizeof(limbo_t))) limbo_t();
         }
@@ -131,6 +138,12 @@ namespace stm
          */
         void add(mm::CustomAllocedBase* ptr);
 
+        /**
+         *  The most objects this reclaimer ever held at once.  Memory that
+         *  long transactions keep from being reused shows up here.
+         */
+        unsigned long getPeak() const { return peak; }
+
       private:
         /**
          *  When the prelimbo list is full, transfer it to the head of the
@@ -146,6 +159,8 @@ inline void stm::Reclaimer::add(mm::CustomAllocedBase* ptr)
     // insert /ptr/ into the pool and increment the pool size
     prelimbo->pool[prelimbo->length] = ptr;
     prelimbo->length++;
+    if (++pending > peak)
+        peak = pending;
 
     // check if we need to transfer this prelimbo node onto the limbo list
     if (prelimbo->length == POOL_SIZE) {
@@ -201,6 +216,7 @@ inline void stm::Reclaimer::transfer()
             for (unsigned long i = 0; i < POOL_SIZE; i++) {
                 delete(current->pool[i]);
             }
+            pending -= POOL_SIZE;
 
             // free the timestamp
             heap->tx_free(current->ts);
@@ -79,6 +79,30 @@ namespace stm
             volatile unsigned long long dword;
         };
 
+#ifdef OREC_TABLE
+        /**
+         *  With OREC_TABLE=on, objects carry no version or owner.  Each
+         *  object hashes to an ownership record in a global table, and many
+         *  objects share each record.  A record holds an odd version
+         *  number, or the (even) Descriptor* of the transaction that owns
+         *  every object hashing to it.  Redo logs stay in the owner's write
+         *  set, and only the owner applies them, after it commits.
+         */
+        static const unsigned long OREC_TABLE_SIZE = 1 << 20;
+
+        extern volatile unsigned long orecs[OREC_TABLE_SIZE];
+
+        /**
+         *  The ownership record of /obj/.  Objects are at least 16 bytes, so
+         *  the low bits of their addresses carry nothing.
+         */
+        inline volatile unsigned long* orec_of(const SharedBase* obj)
+        {
+            return &orecs[(reinterpret_cast<unsigned long>(obj) >> 4)
+                          & (OREC_TABLE_SIZE - 1)];
+        }
+#endif
+
         // tell the world that if you're using SharedBase, you need a redo
         // method
 #define NEED_REDO_METHOD
@@ -100,6 +124,16 @@ namespace stm
             friend class Validator;
             friend class Descriptor;
           protected:
+#ifdef OREC_TABLE
+            /**
+             *  NULL in a shared object; in a redo log, the object that the
+             *  log will be applied to.  The version and owner are in the
+             *  object's orec.
+             */
+            SharedBase* m_master;
+
+            SharedBase() : m_master(NULL) { }
+#else
             /**
              *  Super-union of all the to represent version number, owner
              *  pointer, and lock.  The object is locked if the verison is 2,
@@ -125,6 +159,7 @@ namespace stm
                 m_metadata.fields.ver.version = 1;
                 m_metadata.fields.redoLog = NULL;
             }
+#endif
 
             /**
              *  The user must provide clone, which is a tx-safe copy of the
@@ -39,6 +39,7 @@
 
 #include "CustomAllocedBase.h"
 #include "ObjectBase_rstm.h"
+#include "ReaderIndicator.h"
 
 namespace stm
 {
@@ -114,12 +115,12 @@ namespace stm
             ObjectBase* volatile __attribute__((__may_alias__)) m_payload;
 
             /**
-             *  Visible reader bitmap.  Up to 32 transactions can read an
-             *  object visibly by getting permission to 'own' one of the 32
-             *  global bits and then setting that bit in a shared object's
-             *  visible reader bitmap.
+             *  Visible readers.  By default this is a bitmap in which up to 32
+             *  transactions can read an object visibly by setting the bit of
+             *  their thread id.  With SCALABLE_READERS every thread can, and
+             *  readers are spread over several cache lines.
              */
-            volatile unsigned long m_readers;
+            ReaderIndicator m_readers;
 
             /**
              *  Constructor for shared objects. It is only used through
@@ -133,7 +134,7 @@ namespace stm
              *  is a pointer to that transaction's Descriptor.
              */
             SharedBase(ObjectBase* t, Descriptor* tx = NULL)
-                : m_payload(t), m_readers(0)
+                : m_payload(t), m_readers()
             {
                 assert(m_payload);
 
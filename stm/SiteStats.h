@@ -0,0 +1,123 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2005, 2006
+// University of Rochester
+// Department of Computer Science
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//    * Redistributions of source code must retain the above copyright notice,
+//      this list of conditions and the following disclaimer.
+//
+//    * Redistributions in binary form must reproduce the above copyright
+//      notice, this list of conditions and the following disclaimer in the
+//      documentation and/or other materials provided with the distribution.
+//
+//    * Neither the name of the University of Rochester nor the names of its
+//      contributors may be used to endorse or promote products derived from
+//      this software without specific prior written permission.
+//
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+
+#ifndef __SITESTATS_H__
+#define __SITESTATS_H__
+
+#include <cstring>
+
+namespace stm
+{
+    /**
+     *  Per-thread history of the transactions started at each
+     *  BEGIN_TRANSACTION call site, used to pick a read / acquire rule per
+     *  site when running with -V adaptive.
+     *
+     *  The table is direct mapped on the address of the call site; a site
+     *  that collides with another one simply takes its slot over and starts
+     *  from scratch.  Counts decay by halving, so a site can change its
+     *  preference when the workload changes phase.
+     */
+    class SiteStats
+    {
+      public:
+        struct site_t
+        {
+            const void*   site;
+            unsigned long commits;
+            unsigned long aborts;
+            unsigned long avgReads;   // moving averages, weight 1/8
+            unsigned long avgWrites;
+            int           mode;       // the mode the next attempt runs in
+        };
+
+        /**
+         *  Read sets this long on average count as long
+         */
+        static const unsigned long LONG_READS = 16;
+
+      private:
+        static const unsigned long SITES = 64;
+        static const unsigned long DECAY_AT = 256;
+
+        site_t sites[SITES];
+
+      public:
+        SiteStats() { memset(sites, 0, sizeof(sites)); }
+
+        /**
+         *  Find the entry for /site/, claiming a slot with /initial_mode/
+         *  if the site is new
+         */
+        site_t& lookup(const void* site, int initial_mode)
+        {
+            site_t& s =
+                sites[(reinterpret_cast<unsigned long>(site) >> 2) % SITES];
+            if (s.site != site) {
+                memset(&s, 0, sizeof(s));
+                s.site = site;
+                s.mode = initial_mode;
+            }
+            return s;
+        }
+
+        /**
+         *  Fold the outcome and footprint of one attempt into /s/
+         */
+        static void record(site_t& s, bool committed,
+                           unsigned long reads, unsigned long writes)
+        {
+            // the first sample seeds the averages
+            if (s.commits + s.aborts == 0) {
+                s.avgReads = reads;
+                s.avgWrites = writes;
+            }
+            else {
+                s.avgReads = (7 * s.avgReads + reads) >> 3;
+                s.avgWrites = (7 * s.avgWrites + writes) >> 3;
+            }
+            if (committed)
+                s.commits++;
+            else
+                s.aborts++;
+            if (s.commits + s.aborts > DECAY_AT) {
+                s.commits >>= 1;
+                s.aborts >>= 1;
+            }
+        }
+    };
+}
+
+#endif // __SITESTATS_H__
@@ -51,6 +51,12 @@ namespace stm
         cout << "    VALIDATION HEURISTICS = " << PARAM_HEUR << endl;
         cout << "    TIMING = " << PARAM_TIMING << endl;
         cout << "    CONFLICTS = " << PARAM_CONFLICTS << endl;
+        cout << "    SCALABLE READERS = " << PARAM_READERS << endl;
+        cout << "    IN PLACE WRITES = " << PARAM_IN_PLACE << endl;
+        cout << "    MULTI VERSION = " << PARAM_MULTI_VERSION << endl;
+        cout << "    OREC TABLE = " << PARAM_OREC << endl;
+        cout << "    IRREVOCABLE AFTER = " << PARAM_IRREVOCABLE << endl;
+        cout << "    ABORT MECHANISM = " << PARAM_ABORT << endl;
         cout << "    CGL_LOCK = " << PARAM_LOCK << endl;
         cout << "    PRIVATIZATION = " << PARAM_PRIVATIZATION << endl;
         cout << "    TLS = " << PARAM_TLS << endl;
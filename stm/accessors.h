@@ -127,4 +127,61 @@
       TOKEN_CONCAT(m_, n)[x][y] = TOKEN_CONCAT(tmp_, n);                \
   }
 
+/**
+ *  GENERATE_FIELD for classes derived from InPlaceObject<T>: the setter logs
+ *  the old value of the field before overwriting it
+ */
+#define GENERATE_UNDO_FIELD(t, n)                                       \
+  /* declare the field, with its name prefixed by m_ */                 \
+  protected:                                                            \
+    t TOKEN_CONCAT(m_, n);                                              \
+  public:                                                               \
+  /* declare a getter for a readable (const) version of the object */   \
+  t TOKEN_CONCAT(get_, n)(const stm::internal::Validator& v) const      \
+  {                                                                     \
+      t ret = TOKEN_CONCAT(m_, n);                                      \
+      v.validate(this);                                                 \
+      return ret;                                                       \
+  }                                                                     \
+  /* declare a getter for a writable version of the object */           \
+  t TOKEN_CONCAT(get_, n)(const stm::internal::Validator& v)            \
+  {                                                                     \
+      return TOKEN_CONCAT(m_, n);                                       \
+  }                                                                     \
+  /* declare a setter that logs, for a writable version of the object*/ \
+  void TOKEN_CONCAT(set_, n)(t TOKEN_CONCAT(tmp_, n))                   \
+  {                                                                     \
+      this->logUndo(&TOKEN_CONCAT(m_, n), sizeof(TOKEN_CONCAT(m_, n))); \
+      TOKEN_CONCAT(m_, n) = TOKEN_CONCAT(tmp_, n);                      \
+  }
+
+/**
+ *  GENERATE_ARRAY for classes derived from InPlaceObject<T>: the setter logs
+ *  the old value of the element before overwriting it
+ */
+#define GENERATE_UNDO_ARRAY(t, n, s)                                    \
+  /* declare the field, with its name prefixed by m_ */                 \
+  protected:                                                            \
+    t TOKEN_CONCAT(m_, n)[s];                                           \
+  public:                                                               \
+  /* declare a getter for a readale (const) version of the object */    \
+  t TOKEN_CONCAT(get_, n)(int i, const stm::internal::Validator& v) const \
+  {                                                                     \
+      t ret = TOKEN_CONCAT(m_, n)[i];                                   \
+      v.validate(this);                                                 \
+      return ret;                                                       \
+  }                                                                     \
+  /* declare a getter for a writable version of the object */           \
+  t TOKEN_CONCAT(get_, n)(int i, const stm::internal::Validator& v)     \
+  {                                                                     \
+      return TOKEN_CONCAT(m_, n)[i];                                    \
+  }                                                                     \
+  /* declare a setter that logs, for a writable version of the object */ \
+  void TOKEN_CONCAT(set_, n)(int i, t TOKEN_CONCAT(tmp_, n))            \
+  {                                                                     \
+      this->logUndo(&TOKEN_CONCAT(m_, n)[i],                            \
+                    sizeof(TOKEN_CONCAT(m_, n)[i]));                    \
+      TOKEN_CONCAT(m_, n)[i] = TOKEN_CONCAT(tmp_, n);                   \
+  }
+
 #endif // __ACCESSORS_H__
@@ -78,6 +78,18 @@ static inline void nop()
     asm volatile("nop");
 }
 
+// spin-wait hint: lets a hyperthreaded sibling run and saves power
+static inline void spin_pause()
+{
+    asm volatile("pause");
+}
+
+// memory barrier to prevent reads from bypassing writes
+static inline void membar()
+{
+    asm volatile("mfence" : : : "memory");
+}
+
 // casX for x86 (486 or higher)
 static inline unsigned long long casX(volatile unsigned long long* addr,
                                       unsigned long long oldVal,
@@ -224,6 +236,12 @@ static inline void nop()
     asm volatile("nop");
 }
 
+// no spin-wait hint on SPARC
+static inline void spin_pause()
+{
+    asm volatile("nop");
+}
+
 #endif
 
 static inline bool
@@ -242,6 +260,23 @@ static inline unsigned long fai(volatile unsigned long* ptr)
     return found;
 }
 
+static inline unsigned long fad(volatile unsigned long* ptr)
+{
+    unsigned long found = *ptr;
+    unsigned long expected;
+    do {
+        expected = found;
+    } while ((found = cas(ptr, expected, expected - 1)) != expected);
+    return found;
+}
+
+// keep the compiler from moving loads and stores across this point.  Both
+// platforms keep stores in order (and loads in order) in hardware.
+static inline void cfence()
+{
+    asm volatile("" : : : "memory");
+}
+
 // exponential backoff
 static inline void backoff(int *b)
 {
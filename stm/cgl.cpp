@@ -54,5 +54,9 @@ pthread_mutex_t globalLock __attribute__ ((aligned(64))) =
 #endif
 
 bool stm::terminate __attribute__ ((aligned(64))) = false;
+unsigned long stm::fallback_threshold = 0;
+
+// cgl never contends, so any strategy will do
+bool stm::set_backoff_strategy(std::string) { return true; }
 Descriptor*
 stm::internal::desc_array[MAX_THREADS] __attribute__ ((aligned(64))) = {0};
@@ -126,6 +126,12 @@ extern pthread_mutex_t globalLock;
 
 #endif
 
+// every cgl transaction is already irrevocable
+#define BEGIN_IRREVOCABLE_TRANSACTION BEGIN_TRANSACTION
+
+// nor is there any write-path bookkeeping to skip
+#define BEGIN_RO_TRANSACTION BEGIN_TRANSACTION
+
 namespace stm
 {
     // standard API entry points
@@ -152,6 +158,9 @@ namespace stm
 
     inline void fence() { }
 
+    // nothing can be rolled back, so the transaction just goes on
+    inline void restart() { }
+
     namespace internal
     {
         // tell each descriptor to print its timing information
@@ -260,6 +269,18 @@ namespace stm
         }
     };
 
+    // with a single lock every write is in place, and nothing is undone
+    template<class T>
+    class InPlaceObject : public Object<T>
+    {
+      protected:
+        void logUndo(void* addr, size_t len) { }
+    };
+
+    // nothing is ever validated under a single lock
+    template<class T>
+    class ValueValidatedObject : public Object<T> { };
+
 };
 
 inline void stm::internal::Descriptor::addDtor(internal::SharedBase* ptr)
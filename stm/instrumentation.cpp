@@ -44,6 +44,12 @@ void stm::BasicConflictCounter::REPORT_CONFLICTS(unsigned long id)
               << ", Aborts = "     << counts[EXPLICIT_ABORTS]
               << ", Cleanup = "    << counts[CLEANUP_FAILURES]
               << ", Commits = "    << counts[COMMITS]
+              << ", Clones = "     << counts[CLONES]
+              << ", In place = "   << counts[WRITES_IN_PLACE]
+              << ", Irrevocable = " << counts[IRREVOCABLE_TXNS]
+              << ", Fallbacks = "  << counts[FALLBACKS]
+              << ", Partial aborts = " << counts[PARTIAL_ABORTS]
+              << ", Old versions = " << counts[OLD_VERSIONS]
               << std::endl;
 }
 
@@ -53,7 +53,13 @@ namespace stm
                      EXPLICIT_ABORTS = 2,
                      CLEANUP_FAILURES = 3,
                      COMMITS = 4,
-                     EVENTS_ENUM_SIZE = 5}; // this one is the size of the enum
+                     CLONES = 5,
+                     WRITES_IN_PLACE = 6,
+                     IRREVOCABLE_TXNS = 7,
+                     FALLBACKS = 8,
+                     PARTIAL_ABORTS = 9,
+                     OLD_VERSIONS = 10,
+                     EVENTS_ENUM_SIZE = 11}; // this one is the size of the enum
 
         /**
          *  array for holding all of the counts
@@ -96,6 +102,36 @@ namespace stm
          */
         void ADD_COMMIT() { counts[COMMITS]++; }
 
+        /**
+         *  Increment the CLONES field.
+         */
+        void ADD_CLONE() { counts[CLONES]++; }
+
+        /**
+         *  Increment the WRITES_IN_PLACE field.
+         */
+        void ADD_IN_PLACE() { counts[WRITES_IN_PLACE]++; }
+
+        /**
+         *  Increment the IRREVOCABLE_TXNS field.
+         */
+        void ADD_IRREVOCABLE() { counts[IRREVOCABLE_TXNS]++; }
+
+        /**
+         *  Increment the FALLBACKS field.
+         */
+        void ADD_FALLBACK() { counts[FALLBACKS]++; }
+
+        /**
+         *  Increment the PARTIAL_ABORTS field.
+         */
+        void ADD_PARTIAL_ABORT() { counts[PARTIAL_ABORTS]++; }
+
+        /**
+         *  Increment the OLD_VERSIONS field.
+         */
+        void ADD_OLD_VERSION() { counts[OLD_VERSIONS]++; }
+
         /**
          *  Print all collected data.
          *
@@ -119,6 +155,12 @@ namespace stm
         void ADD_EXPLICIT_ABORT()               { }
         void ADD_CLEANUP_FAIL()                 { }
         void ADD_COMMIT()                       { }
+        void ADD_CLONE()                        { }
+        void ADD_IN_PLACE()                     { }
+        void ADD_IRREVOCABLE()                  { }
+        void ADD_FALLBACK()                     { }
+        void ADD_PARTIAL_ABORT()                { }
+        void ADD_OLD_VERSION()                  { }
         void REPORT_CONFLICTS(unsigned long id) { }
     } __attribute__ ((aligned(64))); // NopConflictCounter
 
@@ -43,15 +43,65 @@
  *  while/try double nesting.  with the new API, one should not need to name
  *  the descriptor and pass it around.  We're keeping it in right now because
  *  it avoids a pthread call in END_TRANSACTION for getting the current
- *  descriptor.
+ *  descriptor.  The address of locallyCachedTransactionSite is unique to each
+ *  use of the macro, so the TM can keep statistics per call site.
+ *
+ *  In RSTM, a transaction begun inside another one is closed nested: if it
+ *  aborts while the enclosing levels are still valid, only it is retried.
+ *  Its commit only merges it into its parent.
+ *
+ *  With ABORT_MECHANISM=LONGJMP, each attempt takes a checkpoint with
+ *  _setjmp, and an abort jumps back to it rather than throwing.  The jump
+ *  runs no destructors, so a transaction body must not keep objects with
+ *  nontrivial destructors, and a local it changes is indeterminate after an
+ *  abort unless it is volatile or set again by the retry.
  */
-#define BEGIN_TRANSACTION                                               \
+#ifndef ABORT_LONGJMP
+#define BEGIN_TRANSACTION_AS(IRREVOCABLE, READ_ONLY)                    \
     stm::internal::Descriptor* locallyCachedTransactionContext = NULL;  \
+    static char locallyCachedTransactionSite;                           \
     do {                                                                \
         try {                                                           \
             locallyCachedTransactionContext =                           \
-                stm::internal::begin_transaction();
+                stm::internal::begin_transaction(                       \
+                    &locallyCachedTransactionSite, IRREVOCABLE, READ_ONLY);
             // body of transaction goes here //
+#else
+#define BEGIN_TRANSACTION_AS(IRREVOCABLE, READ_ONLY)                    \
+    stm::internal::Descriptor* locallyCachedTransactionContext =        \
+        stm::internal::get_descriptor();                                \
+    static char locallyCachedTransactionSite;                           \
+    jmp_buf* locallyCachedOuterCheckpoint =                             \
+        locallyCachedTransactionContext->checkpoint;                    \
+    jmp_buf locallyCachedTransactionCheckpoint;                         \
+    do {                                                                \
+        try {                                                           \
+            locallyCachedTransactionContext->checkpoint =               \
+                &locallyCachedTransactionCheckpoint;                    \
+            if (!_setjmp(locallyCachedTransactionCheckpoint)) {         \
+                stm::internal::begin_transaction(                       \
+                    &locallyCachedTransactionSite, IRREVOCABLE, READ_ONLY);
+                // body of transaction goes here //
+#endif
+
+#define BEGIN_TRANSACTION BEGIN_TRANSACTION_AS(false, false)
+
+/**
+ *  Start a transaction that must not abort, e.g. because it does I/O or is
+ *  too long to ever finish under contention.  It waits for every other
+ *  transaction to finish and keeps new ones from starting until it ends.
+ *  Ends with END_TRANSACTION.  TMs that can't run irrevocably run it as a
+ *  normal transaction, as does RSTM if it is nested in another transaction.
+ */
+#define BEGIN_IRREVOCABLE_TRANSACTION BEGIN_TRANSACTION_AS(true, false)
+
+/**
+ *  Start a transaction that only reads.  It must not open anything for
+ *  writing or allocate, and in exchange keeps no write set, logs no
+ *  allocations and commits without a CAS.  Ends with END_TRANSACTION.  A
+ *  transaction nested in it is read-only too.
+ */
+#define BEGIN_RO_TRANSACTION BEGIN_TRANSACTION_AS(false, true)
 
 
 /**
@@ -62,7 +112,12 @@
  * outside of the TX and then we try to run a new TX, the descriptor we reuse
  * will have stale information that we don't want to lose (for example, it
  * might have visible read bits set)
+ *
+ * With ABORT_MECHANISM=LONGJMP, the enclosing level's checkpoint is back in
+ * place before cleanup(), since a nested level that must abort its parent
+ * jumps from there.
  */
+#ifndef ABORT_LONGJMP
 #define END_TRANSACTION                                     \
             locallyCachedTransactionContext->commit();      \
         } catch (stm::Aborted) {                            \
@@ -74,5 +129,22 @@
     } while (!locallyCachedTransactionContext->cleanup()    \
              && !stm::terminate);                           \
     locallyCachedTransactionContext = NULL;
+#else
+#define END_TRANSACTION                                     \
+                locallyCachedTransactionContext->commit();  \
+            }                                               \
+        } catch (...) {                                     \
+            locallyCachedTransactionContext->checkpoint =   \
+                locallyCachedOuterCheckpoint;               \
+            locallyCachedTransactionContext->abort(false);  \
+            locallyCachedTransactionContext->cleanup();     \
+            throw;                                          \
+        }                                                   \
+        locallyCachedTransactionContext->checkpoint =       \
+            locallyCachedOuterCheckpoint;                   \
+    } while (!locallyCachedTransactionContext->cleanup()    \
+             && !stm::terminate);                           \
+    locallyCachedTransactionContext = NULL;
+#endif
 
 #endif // __MACROS_H__
@@ -160,15 +160,31 @@ namespace stm
 
           public:
             /**
-             *  Event method on beginning of a transaction
+             *  A nested transaction that had logged /commits/ and /aborts/
+             *  entries when it began is rolling back: whatever it allocated
+             *  is garbage, and whatever it deleted stays
              */
-            void onTxBegin()
+            void rollbackTo(unsigned long commits, unsigned long aborts)
+            {
+                for (unsigned long i = aborts;
+                     i < deleteOnAbort.element_count; i++)
+                    reclaimer.add(deleteOnAbort.elements[i]);
+                deleteOnAbort.element_count = aborts;
+                deleteOnCommit.element_count = commits;
+            }
+
+            /**
+             *  Event method on beginning of a transaction.  A declared
+             *  read-only transaction passes /logAllocs/ false: it allocates
+             *  nothing, so there is nothing to undo on abort.
+             */
+            void onTxBegin(bool logAllocs = true)
             {
                 // update the gc epoch
                 globalEpoch.enter_transaction(id);
 
                 // set up alloc logging
-                should_log = true;
+                should_log = logAllocs;
             }
 
             /**
@@ -207,10 +223,29 @@ namespace stm
             mm::TxHeap* getHeap() const { return heap; }
         };
 
+/**
+ *  Call /CALL/ on HybridCMPolicy::dynamicCM as the concrete class named by
+ *  its kind.  The qualified call binds statically, so the switch replaces
+ *  the vtable lookup and the body of the CM can be inlined into each case.
+ */
+#define RSTM_CM_CASE(CM, CALL)                                          \
+        case cm::CM::KIND:                                              \
+            return static_cast<cm::CM*>(dynamicCM)->cm::CM::CALL;
+
+#define RSTM_CM_DISPATCH(CALL)                                          \
+        switch (kind) {                                                 \
+            RSTM_CM_LIST(RSTM_CM_CASE, CALL)                            \
+          default:                                                      \
+            return dynamicCM->CALL;                                     \
+        }
+
         /**
          *  Policy that prefers to use a static CM with all inlined calls and
          *  no vtable overheads, but that lets you specify a different CM at
-         *  run time if that's what you really want.
+         *  run time if that's what you really want.  A CM picked at run time
+         *  is still called directly: each wrapper switches on its kind and
+         *  calls the concrete class, so only CMs the switch does not know
+         *  (BiModalCM) go through the vtable.
          */
         class HybridCMPolicy
         {
@@ -227,11 +262,14 @@ namespace stm
 
             /**
              *  Dynamic contention manager (used only if use_static_cm is
-             *  false).  Has big vtable overhead, but you can pick you CM at
-             *  run time.
+             *  false).  You can pick your CM at run time; calls are
+             *  dispatched on /kind/ rather than through the vtable.
              */
             cm::ContentionManager* dynamicCM;
 
+            ///  Concrete class of dynamicCM
+            cm::CMKind kind;
+
           public:
 
             /**
@@ -239,10 +277,13 @@ namespace stm
              *  CM from the factory.
              */
             HybridCMPolicy(bool static_cm, std::string dynamic_cm)
-                : static_flag(static_cm), staticCM()
+                : static_flag(static_cm), staticCM(), dynamicCM(NULL),
+                  kind(cm::CM_UNKNOWN)
             {
-                if (!static_flag)
+                if (!static_flag) {
                     dynamicCM = cm::Factory(dynamic_cm);
+                    kind = dynamicCM->getKind();
+                }
             }
 
             /**
@@ -258,78 +299,100 @@ namespace stm
             ///  Wrapper around OnBeginTransaction
             void onBeginTx()
             {
-                if (static_flag) staticCM.OnBeginTransaction();
-                else             dynamicCM->OnBeginTransaction();
+                if (static_flag) return staticCM.OnBeginTransaction();
+                RSTM_CM_DISPATCH(OnBeginTransaction());
             }
 
             ///  Wrapper for OnTryCommitTransaction
             void onTryCommitTx()
             {
-                if (static_flag) staticCM.OnTryCommitTransaction();
-                else             dynamicCM->OnTryCommitTransaction();
+                if (static_flag) return staticCM.OnTryCommitTransaction();
+                RSTM_CM_DISPATCH(OnTryCommitTransaction());
             }
 
             ///  Wrapper for OnTransactionCommitted
             void onTxCommitted()
             {
-                if (static_flag) staticCM.OnTransactionCommitted();
-                else             dynamicCM->OnTransactionCommitted();
+                if (static_flag) return staticCM.OnTransactionCommitted();
+                RSTM_CM_DISPATCH(OnTransactionCommitted());
             }
 
             ///  Wrapper for OnTransactionAborted
             void onTxAborted()
             {
-                if (static_flag) staticCM.OnTransactionAborted();
-                else             dynamicCM->OnTransactionAborted();
+                if (static_flag) return staticCM.OnTransactionAborted();
+                RSTM_CM_DISPATCH(OnTransactionAborted());
             }
 
-            ///  Wrapper for onContention
-            void onContention()
+            /**
+             *  Wrapper for onContention.  /enemyState/ and /enemyParked/
+             *  belong to the transaction in our way, if there is one, so
+             *  that the CM can park until it is done.
+             */
+            void onContention(volatile unsigned long* enemyState = NULL,
+                              volatile unsigned long* enemyParked = NULL)
             {
-                if (static_flag) staticCM.onContention();
-                else             dynamicCM->onContention();
+                if (static_flag) {
+                    staticCM.setEnemy(enemyState, enemyParked);
+                    staticCM.onContention();
+                    return;
+                }
+                dynamicCM->setEnemy(enemyState, enemyParked);
+                RSTM_CM_DISPATCH(onContention());
+            }
+
+            ///  Back off before the retry of an aborted transaction
+            void onRetry(unsigned long aborts)
+            {
+                getCM()->beforeRetry(aborts);
             }
 
             ///  Wrapper for OnOpenRead
             void onOpenRead()
             {
-                if (static_flag) staticCM.OnOpenRead();
-                else             dynamicCM->OnOpenRead();
+                if (static_flag) return staticCM.OnOpenRead();
+                RSTM_CM_DISPATCH(OnOpenRead());
             }
 
             ///  Wrapper for OnOpenWrite
             void onOpenWrite()
             {
-                if (static_flag) staticCM.OnOpenWrite();
-                else             dynamicCM->OnOpenWrite();
+                if (static_flag) return staticCM.OnOpenWrite();
+                RSTM_CM_DISPATCH(OnOpenWrite());
             }
 
             ///  Wrapper for OnReOpen
             void onReOpen()
             {
-                if (static_flag) staticCM.OnReOpen();
-                else             dynamicCM->OnReOpen();
+                if (static_flag) return staticCM.OnReOpen();
+                RSTM_CM_DISPATCH(OnReOpen());
             }
 
             ///  Wrapper for ShouldAbort
             bool shouldAbort(cm::ContentionManager* enemy)
             {
                 if (static_flag) return staticCM.ShouldAbort(enemy);
-                else             return dynamicCM->ShouldAbort(enemy);
+                RSTM_CM_DISPATCH(ShouldAbort(enemy));
             }
 
             ///  Wrapper for ShouldAbortAll
-            bool shouldAbortAll(unsigned long bitmap)
+            bool shouldAbortAll(const ReaderIndicator& readers)
             {
-                if (static_flag) return staticCM.ShouldAbortAll(bitmap);
-                else             return dynamicCM->ShouldAbortAll(bitmap);
+                if (static_flag) return staticCM.ShouldAbortAll(readers);
+                RSTM_CM_DISPATCH(ShouldAbortAll(readers));
             }
             
            #ifdef USE_BIMODAL
             /// Wrapper for onConflictWith
             void onConflictWith(int iCore) {
-				if (static_flag) staticCM.onConflictWith(iCore);
-				else 			 dynamicCM->onConflictWith(iCore);
+				if (static_flag) return staticCM.onConflictWith(iCore);
+				RSTM_CM_DISPATCH(onConflictWith(iCore));
+			}
+
+            /// Wrapper for onScheduled
+            void onScheduled(scheduler::BiModalScheduler* sched, int iCore) {
+				if (static_flag) return staticCM.onScheduled(sched, iCore);
+				RSTM_CM_DISPATCH(onScheduled(sched, iCore));
 			}
             #endif
         };
@@ -365,8 +428,19 @@ namespace stm
             ///  Wrapper for OnTransactionAborted
             void onTxAborted() { staticCM.OnTransactionAborted(); }
 
-            ///  Wrapper for onContention
-            void onContention() { staticCM.onContention(); }
+            ///  Wrapper for onContention; see HybridCMPolicy
+            void onContention(volatile unsigned long* enemyState = NULL,
+                              volatile unsigned long* enemyParked = NULL)
+            {
+                staticCM.setEnemy(enemyState, enemyParked);
+                staticCM.onContention();
+            }
+
+            ///  Back off before the retry of an aborted transaction
+            void onRetry(unsigned long aborts)
+            {
+                staticCM.beforeRetry(aborts);
+            }
 
             ///  Wrapper for OnOpenRead
             void onOpenRead() { staticCM.OnOpenRead(); }
@@ -384,9 +458,9 @@ namespace stm
             }
 
             ///  Wrapper for ShouldAbortAll
-            bool shouldAbortAll(unsigned long bitmap)
+            bool shouldAbortAll(const ReaderIndicator& readers)
             {
-                return staticCM.ShouldAbortAll(bitmap);
+                return staticCM.ShouldAbortAll(readers);
             }
             
             #ifdef USE_BIMODAL
@@ -394,6 +468,11 @@ namespace stm
             void onConflictWith(int iCore) {
 				staticCM.onConflictWith(iCore);
 			}
+
+            /// Wrapper for onScheduled
+            void onScheduled(scheduler::BiModalScheduler* sched, int iCore) {
+				staticCM.onScheduled(sched, iCore);
+			}
             #endif
         };
 
@@ -437,8 +516,19 @@ namespace stm
             ///  Wrapper for OnTransactionAborted
             void onTxAborted() { dynamicCM->OnTransactionAborted(); }
 
-            ///  Wrapper for onContention
-            void onContention() { dynamicCM->onContention(); }
+            ///  Wrapper for onContention; see HybridCMPolicy
+            void onContention(volatile unsigned long* enemyState = NULL,
+                              volatile unsigned long* enemyParked = NULL)
+            {
+                dynamicCM->setEnemy(enemyState, enemyParked);
+                dynamicCM->onContention();
+            }
+
+            ///  Back off before the retry of an aborted transaction
+            void onRetry(unsigned long aborts)
+            {
+                dynamicCM->beforeRetry(aborts);
+            }
 
             ///  Wrapper for OnOpenRead
             void onOpenRead() { dynamicCM->OnOpenRead(); }
@@ -456,10 +546,22 @@ namespace stm
             }
 
             ///  Wrapper for ShouldAbortAll
-            bool shouldAbortAll(unsigned long bitmap)
+            bool shouldAbortAll(const ReaderIndicator& readers)
             {
-                return dynamicCM->ShouldAbortAll(bitmap);
+                return dynamicCM->ShouldAbortAll(readers);
             }
+
+            #ifdef USE_BIMODAL
+            /// Wrapper for onConflictWith
+            void onConflictWith(int iCore) {
+				dynamicCM->onConflictWith(iCore);
+			}
+
+            /// Wrapper for onScheduled
+            void onScheduled(scheduler::BiModalScheduler* sched, int iCore) {
+				dynamicCM->onScheduled(sched, iCore);
+			}
+            #endif
         };
     } // namespace stm::internal
 } // namespace stm
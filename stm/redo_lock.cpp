@@ -46,6 +46,12 @@ stm::internal::desc_array[MAX_THREADS] __attribute__ ((aligned(64))) = {0};
  */
 bool stm::terminate __attribute__ ((aligned(64))) = false;
 
+/**
+ *  Provide backing for the fallback threshold declared in stm_common.  This
+ *  TM doesn't use it.
+ */
+unsigned long stm::fallback_threshold = 0;
+
 #ifdef VALIDATION_HEURISTICS
 /**
  *  Ensure that the ValidationPolicy statics are backed
@@ -62,6 +68,24 @@ stm::GlobalCommitCounterValidationPolicy::global_counter = 0;
 volatile unsigned long stm::internal::pcount = 0;
 #endif
 
+#ifdef OREC_TABLE
+/**
+ *  Provide backing for the ownership record table.  Every orec starts out
+ *  unowned, at version 1.
+ */
+volatile unsigned long
+stm::internal::orecs[stm::internal::OREC_TABLE_SIZE] __attribute__ ((aligned(64)));
+
+static struct OrecTableInit
+{
+    OrecTableInit()
+    {
+        for (unsigned long i = 0; i < stm::internal::OREC_TABLE_SIZE; i++)
+            stm::internal::orecs[i] = 1;
+    }
+} orecTableInit;
+#endif
+
 /**
  *  Perform the 'transactional fence'.  If we're using a Validation fence or
  *  Transactional fence, then globalEpoch.waitForDominatingEpoch() will do all
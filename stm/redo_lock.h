@@ -96,12 +96,16 @@ namespace stm
     {
         /**
          *  Logic for the BEGIN_TRANSACTION macro.  Get a descriptor, make sure
-         *  all logs are ready to use, and move to ACTIVE state.
+         *  all logs are ready to use, and move to ACTIVE state.  The call
+         *  site is not used by this TM, and irrevocable transactions run as
+         *  normal ones.
          */
-        inline static Descriptor* begin_transaction()
+        inline static Descriptor* begin_transaction(const void* = NULL,
+                                                    bool = false,
+                                                    bool readOnly = false)
         {
             Descriptor* tx = get_descriptor();
-            tx->beginTransaction();
+            tx->beginTransaction(readOnly);
             return tx;
         }
 
@@ -46,6 +46,29 @@ stm::internal::desc_array[MAX_THREADS] __attribute__ ((aligned(64))) = {0};
  */
 bool stm::terminate __attribute__ ((aligned(64))) = false;
 
+/**
+ *  Provide backing for the fallback threshold declared in stm_common.  The
+ *  IRREVOCABLE_AFTER build option sets its default.
+ */
+#ifdef IRREVOCABLE_AFTER
+unsigned long stm::fallback_threshold = IRREVOCABLE_AFTER;
+#else
+unsigned long stm::fallback_threshold = 0;
+#endif
+
+/**
+ *  Provide backing for the global version clock used by the clock validation
+ *  modes.
+ */
+volatile unsigned long
+stm::internal::global_clock __attribute__ ((aligned(64))) = 0;
+
+/**
+ *  Provide backing for the token of the irrevocable transaction
+ */
+volatile unsigned long
+stm::internal::irrevocable_token __attribute__ ((aligned(64))) = 0;
+
 #ifdef VALIDATION_HEURISTICS
 /**
  *  Ensure that the ValidationPolicy statics are backed
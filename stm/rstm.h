@@ -62,7 +62,8 @@ namespace stm
      * @param cm_type - string indicating what CM to use.
      *
      * @param validation - string indicating vis-eager, vis-lazy, invis-eager,
-     * or invis-lazy
+     * invis-lazy, clock-eager, clock-lazy, or adaptive (pick one of the
+     * first four per transaction call site)
      *
      * @param use_static_cm - if true, use a statically allocated contention
      * manager where all calls are inlined as much as possible.  If false, use
@@ -102,12 +103,15 @@ namespace stm
     {
         /**
          *  Logic for the BEGIN_TRANSACTION macro.  Get a descriptor, make sure
-         *  all logs are ready to use, and move to ACTIVE state.
+         *  all logs are ready to use, and move to ACTIVE state.  /site/
+         *  identifies the BEGIN_TRANSACTION, for -V adaptive.
          */
-        inline static Descriptor* begin_transaction()
+        inline static Descriptor* begin_transaction(const void* site = NULL,
+                                                    bool irrevocable = false,
+                                                    bool readOnly = false)
         {
             Descriptor* tx = get_descriptor();
-            tx->beginTransaction();
+            tx->beginTransaction(site, irrevocable, readOnly);
             return tx;
         }
 
@@ -123,6 +127,19 @@ namespace stm
                 ConflictCounter[desc_array[i]->id].REPORT_CONFLICTS(i);
                 i++;
             }
+#ifdef MULTI_VERSION
+            // what keeping old versions costs: a link in every version, and
+            // versions that snapshot readers keep out of the allocator
+            std::cout << "Multi-version: " << sizeof(ObjectBase*)
+                      << " extra bytes per object version" << std::endl;
+            i = 0;
+            while (desc_array[i]) {
+                std::cout << "Thread " << i << ": peak unreclaimed objects = "
+                          << desc_array[i]->mm.reclaimer.getPeak()
+                          << std::endl;
+                i++;
+            }
+#endif
             // report timing
             i = 0;
             while (desc_array[i]) {
@@ -2,6 +2,9 @@
 
 #include "scheduler_common.h"
 #include <cstdlib>
+#include <sys/time.h>
+#include <errno.h>
+#include "atomic_ops.h"
 
 #include <iostream>
 
@@ -9,77 +12,108 @@ using namespace std;
 using namespace stm::scheduler;
 
 // static members declarations
-long BiModalScheduler::m_lngCoresNum;
 BiModalScheduler* BiModalScheduler::m_Instance;
-SchedulerStatistics* BiModalScheduler::stats;
+SchedulerConfig BiModalScheduler::m_defaultConfig;
 
-ThreadLock* BiModalScheduler::m_threadLock = new ThreadLock();
+ThreadLock* BiModalScheduler::m_instanceLock = new ThreadLock();
 
-BiModalScheduler::BiModalScheduler()
+BiModalScheduler::BiModalScheduler(const SchedulerConfig& config)
+	: m_config(config)
 {
-	m_lngCoresNum = getCoresNum();
-	initExecutingThreads();
+	long lngCpusNum = getOnlineCpusNum();
+	if (m_config.m_cpus.empty())
+		for (int iCpu = 0; iCpu < lngCpusNum; iCpu++)
+			m_config.m_cpus.push_back(iCpu);
+	m_lngCoresNum = m_config.m_cpus.size();
+	// cpu numbers may have holes when some cpus are offline
+	for (int iCore = 0; iCore < m_lngCoresNum; iCore++)
+		if (m_config.m_cpus[iCore] >= lngCpusNum)
+			lngCpusNum = m_config.m_cpus[iCore] + 1;
+	m_cpuToCore.assign(lngCpusNum, -1);
+	for (int iCore = 0; iCore < m_lngCoresNum; iCore++)
+		m_cpuToCore[m_config.m_cpus[iCore]] = iCore;
+	
+	m_threadLock = new ThreadLock();
+	m_topology = new Topology(lngCpusNum);
 	m_roQueue = new Queue();
 	m_epoch = new long(0);
 	m_roQueueCount = new int(0);
 	stats = new SchedulerStatistics();
+	m_lngInFlight = 0;
+	m_coreFastReaders = new unsigned long[m_lngCoresNum * CORE_LINE_LONGS];
+	m_coreSlowTxs = new unsigned long[m_lngCoresNum * CORE_LINE_LONGS];
+	for (int iCore = 0; iCore < m_lngCoresNum * CORE_LINE_LONGS; iCore++) {
+		m_coreFastReaders[iCore] = 0;
+		m_coreSlowTxs[iCore] = 0;
+	}
+	pthread_mutex_init(&m_admissionLock, NULL);
+	pthread_cond_init(&m_condRoom, NULL);
+	// the runners start working right away, everything above must be ready
+	initExecutingThreads();
 }
 
 stm::scheduler::BiModalScheduler::~BiModalScheduler()
 {
-	if (m_Instance)
-	{
-		delete m_threadLock;
-		delete m_roQueue;
-		delete m_epoch;
-		delete m_roQueueCount;
-		delete stats;
-	}
+	delete m_threadLock;
+	delete m_roQueue;
+	delete m_topology;
+	delete m_epoch;
+	delete m_roQueueCount;
+	delete stats;
+	delete[] m_coreFastReaders;
+	delete[] m_coreSlowTxs;
+	pthread_cond_destroy(&m_condRoom);
+	pthread_mutex_destroy(&m_admissionLock);
+}
+
+void BiModalScheduler::configure(const SchedulerConfig& config)
+{
+	m_defaultConfig = config;
 }
 
 void BiModalScheduler::init()
 {
 	// Set the thread's data
-	ThreadData *pThreadData = new ThreadData();
-	threadDataManager.setThreadData(pThreadData);
+	threadDataManager.getOrCreateThreadData();
 	if (!m_Instance)
 	{
-		m_threadLock->Lock();
+		m_instanceLock->Lock();
 		if (!m_Instance)
 		{
-			m_Instance = new BiModalScheduler();
-			stats = new SchedulerStatistics();
+			m_Instance = new BiModalScheduler(m_defaultConfig);
 			cout << "Scheduler initialized end" << endl;
 		}
-		m_threadLock->Unlock();
+		m_instanceLock->Unlock();
 	}
 }
 
 stm::scheduler::BiModalScheduler* BiModalScheduler::instance()
-{/*
-  if (!m_Instance)
-	{
-		cout << "Fault in StmScheduler. Exiting!" << endl;
-		// Throw an exception
-		exit(1);
-		}
-	*/return m_Instance;
+{
+	return m_Instance;
 }
 
 void BiModalScheduler::shutdown()
 {
-	BiModalScheduler* scheduler = instance();
-	scheduler->stats->finalEpoch = *scheduler->m_epoch;
+	m_Instance->stop();
+	delete m_Instance;
+	m_Instance = NULL;
+}
+
+void BiModalScheduler::stop()
+{
+	stats->finalEpoch = *m_epoch;
+	stats->numFastReads = 0;
+	for (int iCore = 0; iCore < m_lngCoresNum; iCore++)
+		stats->numFastReads += m_coreFastReaders[iCore * CORE_LINE_LONGS + 1];
 	stats->printStats();
 	/* Go over all runner threads, and shut down each thread */
 	for (int iThread = 0; iThread < m_lngCoresNum; iThread++)
 	{
-		scheduler->m_arThreads[iThread]->shutdown();
+		m_arThreads[iThread]->shutdown();
 	}
-	delete m_Instance;
 }
 
-long stm::scheduler::BiModalScheduler::getCoresNum()
+long stm::scheduler::BiModalScheduler::getOnlineCpusNum()
 {
 	long lngCoresNum = 0;
 	lngCoresNum = sysconf(_SC_NPROCESSORS_ONLN);
@@ -90,29 +124,339 @@ long stm::scheduler::BiModalScheduler::getCoresNum()
  * When a new transation enters the system, we schedule it on the 
  * core which has less transactions in his queue
  */
-void *stm::scheduler::BiModalScheduler::schedule(void *(*pFunc)(void*), void *pArgs)
+int stm::scheduler::BiModalScheduler::pickCore(void *(*pFunc)(void*))
 {
-	void* result = NULL;
-	int iCore = 0;
-	iCore = sched_getcpu();
-	bool found = false;
-	int iCurQueueSize;
+	int iPredicted = predictCore(pFunc);
+	if (iPredicted >= 0)
+		return iPredicted;
+	
+	int iCaller = sched_getcpu();
+	if (iCaller < 0 || iCaller >= (int)m_cpuToCore.size())
+		iCaller = m_config.m_cpus[0];
+	int iCore = m_cpuToCore[iCaller];
+	if (iCore < 0)
+		iCore = 0;
 	int iMinJobs = m_arThreads[iCore]->getJobsNum();
-	for (int iQueue = 0; (iQueue < m_lngCoresNum) && !found; iQueue++) {
-		iCurQueueSize = m_arThreads[iQueue]->getJobsNum();
-		if (iCurQueueSize <= iMinJobs) {
+	bool blnMinRemote = !m_topology->shareL3(iCaller, m_arThreads[iCore]->getCpuID());
+	bool blnMinSiblingBusy = siblingBusy(iCore);
+	for (int iQueue = 0; iQueue < m_lngCoresNum; iQueue++) {
+		int iCurQueueSize = m_arThreads[iQueue]->getJobsNum();
+		if (iCurQueueSize > iMinJobs)
+			continue;
+		bool blnRemote = !m_topology->shareL3(iCaller, m_arThreads[iQueue]->getCpuID());
+		bool blnSiblingBusy = siblingBusy(iQueue);
+		if (iCurQueueSize == iMinJobs) {
+			if (blnRemote && !blnMinRemote)
+				continue;
+			if (blnRemote == blnMinRemote && (blnSiblingBusy || !blnMinSiblingBusy))
+				continue;
+		}
+		iCore = iQueue;
+		iMinJobs = iCurQueueSize;
+		blnMinRemote = blnRemote;
+		blnMinSiblingBusy = blnSiblingBusy;
+		// can't do better than an empty queue next to us on a quiet physical core
+		if (iMinJobs == 0 && !blnMinRemote && !blnMinSiblingBusy)
+			break;
+	}
+	return iCore;
+}
+
+/*
+ * Running the job after a core that writes what it is about to access costs
+ * less than the conflict we would get by running them side by side
+ */
+int BiModalScheduler::predictCore(void *(*pFunc)(void*))
+{
+	if (!m_config.m_blnPredictConflicts || !pFunc)
+		return -1;
+	BloomFilter accesses;
+	m_threadLock->Lock();
+	map<void *(*)(void*), BloomFilter>::iterator it = m_jobTypeAccesses.find(pFunc);
+	bool blnKnown = it != m_jobTypeAccesses.end();
+	if (blnKnown)
+		accesses = it->second;
+	m_threadLock->Unlock();
+	if (!blnKnown)
+		return -1;
+	
+	int iCore = -1;
+	int iMinJobs = 0;
+	for (int iQueue = 0; iQueue < m_lngCoresNum; iQueue++) {
+		if (!isBusy(iQueue) || !m_arThreads[iQueue]->mayConflict(accesses))
+			continue;
+		int iCurQueueSize = m_arThreads[iQueue]->getJobsNum();
+		if (iCore < 0 || iCurQueueSize < iMinJobs) {
 			iCore = iQueue;
 			iMinJobs = iCurQueueSize;
-			if (iCurQueueSize == 0)
-				found = true;
 		}
 	}
-	result = m_arThreads[iCore]->addJob(pFunc, pArgs, threadDataManager.getThreadData());
-	//cout << "Job scheduled in core " << iCore << endl;
+	if (iCore >= 0) {
+		m_threadLock->Lock();
+		stats->numPredicted++;
+		m_threadLock->Unlock();
+	}
+	return iCore;
+}
 
+void BiModalScheduler::learnAccesses(void *(*pFunc)(void*), const BloomFilter& accesses)
+{
+	m_threadLock->Lock();
+	m_jobTypeAccesses[pFunc] = accesses;
+	m_threadLock->Unlock();
+}
+
+bool BiModalScheduler::isBusy(int iCore)
+{
+	return !m_arThreads[iCore]->isIdle();
+}
+
+/*
+ * Only siblings that run our own runners are known to us
+ */
+bool BiModalScheduler::siblingBusy(int iCore)
+{
+	const vector<int>& siblings = m_topology->getSiblings(m_arThreads[iCore]->getCpuID());
+	for (unsigned int i = 0; i < siblings.size(); i++)
+		if (m_cpuToCore[siblings[i]] >= 0 && isBusy(m_cpuToCore[siblings[i]]))
+			return true;
+	return false;
+}
+
+void *stm::scheduler::BiModalScheduler::schedule(void *(*pFunc)(void*), void *pArgs)
+{
+	void* result = NULL;
+	trySchedule(pFunc, pArgs, &result);
 	return result;
 }
 
+int stm::scheduler::BiModalScheduler::trySchedule(void *(*pFunc)(void*), void *pArgs, void **pResult, int iPriority)
+{
+	InnerJob* newJob = new InnerJob(pFunc, pArgs, threadDataManager.getOrCreateThreadData(), iPriority);
+	int iStatus = SCHEDULE_OK;
+	int iCore;
+	bool blnClaimed = false;
+
+	if (!m_config.isBounded()) {
+		iCore = pickCore(pFunc);
+		blnClaimed = claimCore(iCore, newJob);
+		if (!blnClaimed)
+			m_arThreads[iCore]->addJob(newJob);
+	} else {
+		// the job is queued under the admission lock, so that concurrent
+		// submissions can't overfill a queue they both saw room in
+		pthread_mutex_lock(&m_admissionLock);
+		iCore = admit(newJob, &iStatus);
+		if (iCore >= 0) {
+			m_lngInFlight++;
+			blnClaimed = claimCore(iCore, newJob);
+			if (!blnClaimed)
+				m_arThreads[iCore]->addJob(newJob);
+		}
+		pthread_mutex_unlock(&m_admissionLock);
+		if (iCore < 0) {
+			delete newJob;
+			return iStatus;
+		}
+	}
+	//cout << "Job scheduled in core " << iCore << endl;
+
+	if (blnClaimed) {
+		// run it here, under the identity of the core's runner
+		bool blnDone = m_arThreads[iCore]->runClaimed();
+		if (blnDone)
+			onJobDone();
+		m_threadLock->Lock();
+		stats->numInline++;
+		if (!blnDone)
+			stats->numInlineRescheduled++;
+		m_threadLock->Unlock();
+	}
+
+	// wait for the job to end, it may still be shed while it waits in a queue
+	void* result = newJob->waitForFinish();
+	iStatus = newJob->getStatus();
+	delete newJob;
+	if (iStatus == SCHEDULE_OK && pResult)
+		*pResult = result;
+	return iStatus;
+}
+
+/*
+ * Caller-runs: the submitting thread may take the core if its queue is empty
+ * and no reading epoch is in progress
+ */
+bool BiModalScheduler::claimCore(int iCore, InnerJob* job)
+{
+	if (!m_config.m_blnCallerRuns)
+		return false;
+	long epoch = *m_epoch;
+	if (IS_READING(epoch))
+		return false;
+	return m_arThreads[iCore]->tryClaim(job, epoch);
+}
+
+int stm::scheduler::BiModalScheduler::scheduleGraph(JobGraph& graph)
+{
+	if (graph.size() == 0)
+		return SCHEDULE_OK;
+	if (!graph.isAcyclic())
+		return SCHEDULE_INVALID;
+	
+	vector<InnerJob*> roots;
+	graph.start(roots, m_config.isBounded() ? this : NULL);
+	
+	int iStatus = SCHEDULE_OK;
+	if (!m_config.isBounded()) {
+		for (unsigned int i = 0; i < roots.size(); i++)
+			m_arThreads[pickCore(roots[i]->getFunc())]->addJob(roots[i]);
+	} else {
+		// the first root is admitted like a single submission, the others
+		// run alongside it if there is room. The graph's lock keeps the
+		// commit of the first root out until they are accounted for.
+		pthread_mutex_lock(graph.m_lock);
+		pthread_mutex_lock(&m_admissionLock);
+		int iCore = admit(roots[0], &iStatus);
+		if (iCore >= 0) {
+			m_lngInFlight++;
+			m_arThreads[iCore]->addJob(roots[0]);
+		}
+		pthread_mutex_unlock(&m_admissionLock);
+		if (iCore >= 0) {
+			graph.m_ready.insert(graph.m_ready.end(), roots.begin() + 1, roots.end());
+			admitGraphJobs(graph, iCore);
+		}
+		pthread_mutex_unlock(graph.m_lock);
+		if (iCore < 0)
+			return iStatus;
+	}
+	
+	// successors are queued by the runners as their predecessors commit
+	graph.waitForAll();
+	onJobDone();
+	return SCHEDULE_OK;
+}
+
+void BiModalScheduler::admitGraphJobs(JobGraph& graph, int iNearCore)
+{
+	pthread_mutex_lock(&m_admissionLock);
+	while (!graph.m_ready.empty()) {
+		InnerJob* job = graph.m_ready.front();
+		int iCore = iNearCore;
+		if (!hasRoom(iCore))
+			iCore = pickCore(job->getFunc());
+		if (!hasRoom(iCore))
+			break;
+		graph.m_ready.pop_front();
+		m_lngInFlight++;
+		m_arThreads[iCore]->addJob(job);
+	}
+	pthread_mutex_unlock(&m_admissionLock);
+}
+
+bool BiModalScheduler::hasRoom(int iCore)
+{
+	if (m_config.m_lngGlobalCapacity > 0 && m_lngInFlight >= m_config.m_lngGlobalCapacity)
+		return false;
+	if (m_config.m_iCoreCapacity > 0 && m_arThreads[iCore]->getJobsNum() >= m_config.m_iCoreCapacity)
+		return false;
+	return true;
+}
+
+/*
+ * Called with m_admissionLock held
+ */
+int BiModalScheduler::admit(InnerJob* job, int* piStatus)
+{
+	int iPriority = job->getPriority();
+	struct timespec deadline;
+	if (m_config.m_lngBlockTimeoutMs > 0) {
+		struct timeval now;
+		gettimeofday(&now, NULL);
+		long long nsec = (long long)now.tv_usec * 1000 + (long long)(m_config.m_lngBlockTimeoutMs % 1000) * 1000000;
+		deadline.tv_sec = now.tv_sec + m_config.m_lngBlockTimeoutMs / 1000 + nsec / 1000000000;
+		deadline.tv_nsec = nsec % 1000000000;
+	}
+	
+	bool blnThrottled = false;
+	int iCore = pickCore(job->getFunc());
+	while (!hasRoom(iCore)) {
+		if (m_config.m_admission == ADMIT_FAIL_FAST) {
+			stats->numRejected++;
+			*piStatus = SCHEDULE_BUSY;
+			return -1;
+		}
+		
+		if (m_config.m_admission == ADMIT_SHED) {
+			// find the queue holding the lowest priority job
+			int iVictimCore = -1;
+			int iLowest = iPriority;
+			for (int iQueue = 0; iQueue < m_lngCoresNum; iQueue++) {
+				int iQueueLowest = m_arThreads[iQueue]->lowestQueuedPriority(iLowest);
+				if (iQueueLowest < iLowest) {
+					iLowest = iQueueLowest;
+					iVictimCore = iQueue;
+				}
+			}
+			InnerJob* victim = NULL;
+			if (iVictimCore >= 0)
+				victim = m_arThreads[iVictimCore]->shedJob(iPriority);
+			if (!victim) {
+				// nothing queued is less important, shed the new job
+				stats->numRejected++;
+				*piStatus = SCHEDULE_SHED;
+				return -1;
+			}
+			victim->cancel(SCHEDULE_SHED);
+			m_lngInFlight--;
+			stats->numShed++;
+			// the victim's queue has room now
+			iCore = iVictimCore;
+			continue;
+		}
+		
+		// ADMIT_BLOCK
+		blnThrottled = true;
+		if (m_config.m_lngBlockTimeoutMs > 0) {
+			if (pthread_cond_timedwait(&m_condRoom, &m_admissionLock, &deadline) == ETIMEDOUT) {
+				iCore = pickCore(job->getFunc());
+				if (hasRoom(iCore))
+					break;
+				stats->numRejected++;
+				stats->numTimedOut++;
+				*piStatus = SCHEDULE_TIMEOUT;
+				return -1;
+			}
+		} else {
+			pthread_cond_wait(&m_condRoom, &m_admissionLock);
+		}
+		iCore = pickCore(job->getFunc());
+	}
+	
+	if (blnThrottled)
+		stats->numThrottled++;
+	return iCore;
+}
+
+void BiModalScheduler::onJobDequeued()
+{
+	if (m_config.m_iCoreCapacity <= 0)
+		return;
+	pthread_mutex_lock(&m_admissionLock);
+	pthread_cond_broadcast(&m_condRoom);
+	pthread_mutex_unlock(&m_admissionLock);
+}
+
+void BiModalScheduler::onJobDone()
+{
+	if (!m_config.isBounded())
+		return;
+	pthread_mutex_lock(&m_admissionLock);
+	m_lngInFlight--;
+	pthread_cond_broadcast(&m_condRoom);
+	pthread_mutex_unlock(&m_admissionLock);
+}
+
 /******** Threads related ************/
 
 void stm::scheduler::BiModalScheduler::initExecutingThreads()
@@ -123,9 +467,21 @@ void stm::scheduler::BiModalScheduler::initExecutingThreads()
 	m_arThreads = new RunnerThread*[m_lngCoresNum];
 
 	// Initialize each thread.
+	m_iPhysicalCoresNum = 0;
 	for (iThread = 0; iThread < m_lngCoresNum; iThread++)
 	{
-		m_arThreads[iThread] = new RunnerThread(iThread);
+		int iCpu = m_config.m_cpus[iThread];
+		m_arThreads[iThread] = new RunnerThread(this, iThread, iCpu);
+		
+		// rank the runner among the runners of its physical core
+		int iSmtRank = 0;
+		const vector<int>& siblings = m_topology->getSiblings(iCpu);
+		for (unsigned int i = 0; i < siblings.size(); i++)
+			if (m_cpuToCore[siblings[i]] >= 0 && siblings[i] < iCpu)
+				iSmtRank++;
+		m_arThreads[iThread]->setSmtRank(iSmtRank);
+		if (iSmtRank == 0)
+			m_iPhysicalCoresNum++;
 	}
 
 	for (iThread = 0; iThread < m_lngCoresNum; iThread++)
@@ -135,10 +491,41 @@ void stm::scheduler::BiModalScheduler::initExecutingThreads()
 	}
 }
 
+/*
+ * The loser is normally queued right behind the winner. When the winner's
+ * queue is already long, it goes to the least loaded core of the same L3
+ * domain instead, but never to a hyperthread sibling of the winner, where
+ * the two would fight over the same L1, nor back to the loser's own core.
+ * Leaving the winner gives up the serialization, so the spill target must
+ * have more than RESCHEDULE_SPILL_JOBS jobs less waiting.
+ */
+int BiModalScheduler::pickRescheduleCore(int iFromCore, int iToCore)
+{
+	int iTarget = iToCore;
+	int iWinnerJobs = m_arThreads[iToCore]->getJobsNum();
+	if (iWinnerJobs <= RESCHEDULE_SPILL_JOBS)
+		return iToCore;
+	int iMinJobs = iWinnerJobs - RESCHEDULE_SPILL_JOBS;
+	int iToCpu = m_arThreads[iToCore]->getCpuID();
+	for (int iQueue = 0; iQueue < m_lngCoresNum; iQueue++) {
+		int iCpu = m_arThreads[iQueue]->getCpuID();
+		if (iQueue == iToCore || iQueue == iFromCore)
+			continue;
+		if (!m_topology->shareL3(iCpu, iToCpu) || m_topology->areSiblings(iCpu, iToCpu))
+			continue;
+		if (m_arThreads[iQueue]->getJobsNum() < iMinJobs) {
+			iTarget = iQueue;
+			iMinJobs = m_arThreads[iQueue]->getJobsNum();
+		}
+	}
+	return iTarget;
+}
+
 void BiModalScheduler::reschedule(int iFromCore, int iToCore)
 {
-	cout << "Rescheduling from: " << iFromCore << " to: " << iToCore << endl;
-	m_arThreads[iFromCore]->moveJob(m_arThreads[iToCore]);
+	int iTarget = pickRescheduleCore(iFromCore, iToCore);
+	cout << "Rescheduling from: " << iFromCore << " to: " << iTarget << endl;
+	m_arThreads[iFromCore]->moveJob(m_arThreads[iTarget]);
 	throw RescheduleException();
 }
 
@@ -204,3 +591,65 @@ void BiModalScheduler::increaseAllQueueEmptyCounter() {
 	stats->numAllQueueEmpty++;
     m_threadLock->Unlock();
 }
+
+/*
+ * Fast readers announce themselves before looking for other transactions, and
+ * the others do the opposite, so that at most one side goes ahead when they race.
+ * A core runs one transaction at a time, so each counter of a core has a single
+ * writer; fai is only there for its fence.
+ */
+bool BiModalScheduler::anyOnCores(volatile unsigned long* counts)
+{
+	for (int iCore = 0; iCore < m_lngCoresNum; iCore++)
+		if (counts[iCore * CORE_LINE_LONGS] != 0)
+			return true;
+	return false;
+}
+
+bool BiModalScheduler::enterFastRead(int iCore)
+{
+	if (!m_config.m_blnFastReads)
+		return false;
+	RunnerThread* runner = m_arThreads[iCore];
+	if (!IS_READING(runner->getCurrentEpoch()) || !runner->isTxRO())
+		return false;
+	volatile unsigned long* fast = &m_coreFastReaders[iCore * CORE_LINE_LONGS];
+	fai(fast);
+	if (!anyOnCores(m_coreSlowTxs)) {
+		// the core's count of fast reads shares the line of its announcement
+		fast[1]++;
+		return true;
+	}
+	// some transaction may write, take the normal path
+	fad(fast);
+	return false;
+}
+
+void BiModalScheduler::leaveFastRead(int iCore)
+{
+	fad(&m_coreFastReaders[iCore * CORE_LINE_LONGS]);
+}
+
+void BiModalScheduler::onFastReadFallback(int iCore)
+{
+	m_arThreads[iCore]->setTxRO(false);
+	m_threadLock->Lock();
+	stats->numFastReadFallbacks++;
+	m_threadLock->Unlock();
+}
+
+void BiModalScheduler::enterTx(int iCore)
+{
+	if (!m_config.m_blnFastReads)
+		return;
+	fai(&m_coreSlowTxs[iCore * CORE_LINE_LONGS]);
+	// fast readers never wait on anything, so this ends quickly
+	while (anyOnCores(m_coreFastReaders))
+		nop();
+}
+
+void BiModalScheduler::leaveTx(int iCore)
+{
+	if (m_config.m_blnFastReads)
+		fad(&m_coreSlowTxs[iCore * CORE_LINE_LONGS]);
+}
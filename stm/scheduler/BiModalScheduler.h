@@ -1,48 +1,87 @@
 /*
  * The BiModal Scheduler
- * this class is a singleton , his purpose is to reschedule aborted 
- * transactions, whether in the RO Queue, or in the queue of the core 
- * where the winning transaction is excecuted. It also stores the current
- * epoch number and is responsible for the epoch changing
+ * its purpose is to reschedule aborted transactions, whether in the RO Queue,
+ * or in the queue of the core where the winning transaction is excecuted.
+ * It also stores the current epoch number and is responsible for the epoch
+ * changing.
+ * 
+ * Each instance has its own runners, epoch and RO queue, so unrelated 
+ * workloads can be partitioned onto disjoint cpus. The static init(), 
+ * instance() and shutdown() manage a default instance that uses every cpu.
  * 
  */ 
 
+#ifndef __STM_BIMODAL_SCHEDULER__
+#define __STM_BIMODAL_SCHEDULER__
+
 #include "RunnerThread.h"
 #include "ThreadLock.h"
 #include "Queue.h"
 #include "SchedulerStatistics.h"
+#include "SchedulerConfig.h"
+#include "JobGraph.h"
+#include "Topology.h"
+#include "BloomFilter.h"
+#include <map>
 
 namespace stm {
 	namespace scheduler {
 	
 	class BiModalScheduler {
-		// Members and methods to keep this class a singleton
+		// Members and methods to manage the default instance
 		private:
 			
-			static ThreadLock* m_threadLock;
+			static ThreadLock* m_instanceLock;
 			static BiModalScheduler* m_Instance;
-			BiModalScheduler();
-			~BiModalScheduler();
+			static SchedulerConfig m_defaultConfig;
 		public:
+			// Must be called before the first init() to take effect
+			static void configure(const SchedulerConfig& config);
 			static void init();
 			static BiModalScheduler* instance();
 			static void shutdown();
 			
+			// Creates an instance and starts its runners
+			BiModalScheduler(const SchedulerConfig& config);
+			~BiModalScheduler();
+			
+			// Stops the runners of this instance and prints its statistics
+			void stop();
+			
 			// Members and methods related to the scheduling
 		private:
-			static SchedulerStatistics *stats;
+			ThreadLock* m_threadLock;
+			SchedulerStatistics *stats;
+			SchedulerConfig m_config;
 		
 			friend class RunnerThread;
-			// Holds the number of cores in the system
-			static long m_lngCoresNum;
+			friend class JobGraph;
+			// Holds the number of runners of this instance
+			long m_lngCoresNum;
 			// An array of threads that are used, each thread for a core
 			RunnerThread **m_arThreads;
+			// The runner pinned to each cpu of the machine, -1 for cpus of other instances
+			std::vector<int> m_cpuToCore;
 			
 
 
 			// Initializes the threads that are responsible to do activate the transaction-function
 			void initExecutingThreads();
 			
+			// The cpus, L3 domains and sockets the runners are placed on
+			Topology* m_topology;
+			// Runners that are the first hyperthread of their physical core
+			int m_iPhysicalCoresNum;
+			
+			// A runner is busy if it runs a job or has some waiting
+			bool isBusy(int iCore);
+			
+			// True if a hyperthread sibling of iCore is busy
+			bool siblingBusy(int iCore);
+			
+			// The core the loser of a conflict on iFromCore with iToCore's job is moved to
+			int pickRescheduleCore(int iFromCore, int iToCore);
+			
 			// The number of the current epoch
 			long* m_epoch;
 			int* m_roQueueCount;
@@ -50,9 +89,64 @@ namespace stm {
 			// The Queue where the read-only transactions will be stored
 			Queue* m_roQueue;
 			
+			/*
+			 * Admission control, only used when m_config is bounded
+			 */
+			pthread_mutex_t m_admissionLock;
+			pthread_cond_t m_condRoom;
+			// Jobs admitted and not finished yet
+			long m_lngInFlight;
+			
+			/*
+			 * The core with the shortest queue. Ties go to cores sharing the
+			 * caller's L3, then to cores whose hyperthread siblings are idle.
+			 * A job of type pFunc goes behind a core it is predicted to conflict with.
+			 */
+			int pickCore(void *(*pFunc)(void*) = NULL);
+			
+			/*
+			 * Conflict prediction, only used when m_config.m_blnPredictConflicts is set.
+			 * The objects each type of job accessed the last time one committed.
+			 */
+			std::map<void *(*)(void*), BloomFilter> m_jobTypeAccesses;
+			
+			// The busy core with the shortest queue whose writes meet what pFunc is expected to access, or -1
+			int predictCore(void *(*pFunc)(void*));
+			
+			bool hasRoom(int iCore);
+			
+			// Lends iCore to the calling thread for job when caller-runs applies
+			bool claimCore(int iCore, InnerJob* job);
+			
+			// Blocks, fails or sheds until there is room for job, returns the core to use or -1
+			int admit(InnerJob* job, int* piStatus);
+			
+			/*
+			 * Queues the ready jobs of a bounded graph that fit without waiting,
+			 * preferably on iNearCore. The others stay in the graph until one of
+			 * its jobs commits. Called with the graph's lock held.
+			 */
+			void admitGraphJobs(JobGraph& graph, int iNearCore);
+			
+			/*
+			 * Fast reads, only used when m_config.m_blnFastReads is set.
+			 * Fast readers and other transactions exclude each other. Each
+			 * core counts its own in flight, on a line of its own (entry
+			 * iCore * CORE_LINE_LONGS), so that neither side writes a shared
+			 * line; the entry after a core's fast reader count counts its fast reads.
+			 */
+			volatile unsigned long* m_coreFastReaders;
+			volatile unsigned long* m_coreSlowTxs;
+			
+			// True if some core has a non zero count
+			bool anyOnCores(volatile unsigned long* counts);
+			
 		public:
+			// Returns the number of runners of this instance
+			long getCoresNum() { return m_lngCoresNum; }
+			
 			// Returns the number of cores that are on the machine
-			long getCoresNum();
+			static long getOnlineCpusNum();
 		
 			/*
 			 * Schedules the transaction thread that calls it.
@@ -60,6 +154,22 @@ namespace stm {
 			 * is allowed to run.
 			 */
 			void *schedule(void *(*pFunc)(void*), void *pArgs);
+			
+			/*
+			 * Same as schedule, but subject to the admission policy of the 
+			 * scheduler. Returns a ScheduleStatus, *pResult is only set when
+			 * the job has run (SCHEDULE_OK).
+			 */
+			int trySchedule(void *(*pFunc)(void*), void *pArgs, void **pResult, int iPriority = 0);
+			
+			/*
+			 * Runs a graph of dependent jobs and returns once all of them have
+			 * committed. When bounded, the graph's first job goes through
+			 * admission like a single submission, and every other job runs
+			 * once it is ready and there is room for it, or else takes over
+			 * the slot of a job of the graph that commits. Returns a ScheduleStatus.
+			 */
+			int scheduleGraph(JobGraph& graph);
 
 			/* 
 			 * Reschedules the job that currently runs on the iFromCore to the iToCore.
@@ -83,6 +193,44 @@ namespace stm {
 			
 			bool allQueuesEmpty();
 			
+			/*
+			 * Called when the transaction on iCore begins. True if it may run as a
+			 * fast reader: a read-only job of a reading epoch with no other kind of
+			 * transaction in flight. leaveFastRead() must follow when it is done.
+			 * Only transactions of this instance's runners are seen: threads
+			 * outside the scheduler must not write the data its fast readers read.
+			 */
+			bool enterFastRead(int iCore);
+			void leaveFastRead(int iCore);
+			
+			// Called by a fast reader about to write, it retries as a normal transaction
+			void onFastReadFallback(int iCore);
+			
+			// Feeds the conflict predictor with the objects the transaction on iCore opens
+			inline void noteOpen(int iCore, const void* addr, bool blnWrite)
+			{
+				if (!m_config.m_blnPredictConflicts)
+					return;
+				if (blnWrite)
+					m_arThreads[iCore]->noteWrite(addr);
+				else
+					m_arThreads[iCore]->noteRead(addr);
+			}
+			
+			// Called by a runner when a job of type pFunc has committed
+			void learnAccesses(void *(*pFunc)(void*), const BloomFilter& accesses);
+			
+			/*
+			 * Brackets any transaction that is not a fast reader, waiting for
+			 * the fast readers in flight to finish
+			 */
+			void enterTx(int iCore);
+			void leaveTx(int iCore);
+			
+			// Called by the runners so that blocked submissions can retry
+			void onJobDequeued();
+			void onJobDone();
+			
 			
 			/*
 			 * Statistics related methods
@@ -94,3 +242,5 @@ namespace stm {
 		
 	}
 }
+
+#endif //__STM_BIMODAL_SCHEDULER__
@@ -0,0 +1,75 @@
+/*
+ * A fixed size Bloom filter of object addresses, used to predict which jobs
+ * are going to conflict. Two bits are set per address.
+ * The words are volatile so that other threads may test a filter while its
+ * single writer adds to it; see RunnerThread::mayConflict.
+ *
+ */
+
+#ifndef __STM_BLOOMFILTER__
+#define __STM_BLOOMFILTER__
+
+// Must be a power of two
+#define BLOOM_FILTER_BITS 1024
+
+namespace stm {
+	namespace scheduler {
+
+		class BloomFilter {
+			private:
+				static const int WORD_BITS = sizeof(unsigned long) * 8;
+				static const int WORDS = BLOOM_FILTER_BITS / WORD_BITS;
+
+				volatile unsigned long m_bits[WORDS];
+
+				void set(unsigned long bit) { m_bits[bit / WORD_BITS] |= 1UL << (bit % WORD_BITS); }
+
+			public:
+				BloomFilter() { clear(); }
+				
+				BloomFilter(const BloomFilter& other) { *this = other; }
+				
+				BloomFilter& operator=(const BloomFilter& other)
+				{
+					for (int i = 0; i < WORDS; i++)
+						m_bits[i] = other.m_bits[i];
+					return *this;
+				}
+
+				void clear()
+				{
+					for (int i = 0; i < WORDS; i++)
+						m_bits[i] = 0;
+				}
+
+				void add(const void* addr)
+				{
+					// objects are at least word aligned, the low bits carry nothing
+					unsigned long key = (unsigned long)addr >> 3;
+					unsigned long hash = key * 2654435761UL;
+					set(hash & (BLOOM_FILTER_BITS - 1));
+					set((hash >> 16) & (BLOOM_FILTER_BITS - 1));
+				}
+
+				bool intersects(const BloomFilter& other) const
+				{
+					for (int i = 0; i < WORDS; i++)
+						if (m_bits[i] & other.m_bits[i])
+							return true;
+					return false;
+				}
+
+				bool empty() const
+				{
+					for (int i = 0; i < WORDS; i++)
+						if (m_bits[i])
+							return false;
+					return true;
+				}
+		};
+
+	}
+}
+
+
+#endif //__STM_BLOOMFILTER__
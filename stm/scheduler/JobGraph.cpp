@@ -0,0 +1,119 @@
+#include "JobGraph.h"
+#include "RunnerThread.h"
+#include "BiModalScheduler.h"
+
+using namespace std;
+using namespace stm::scheduler;
+
+JobGraph::JobGraph() : m_lock(NULL), m_condDone(NULL), m_iRemaining(0), m_bounded(NULL)
+{
+}
+
+JobGraph::~JobGraph()
+{
+	for (unsigned int i = 0; i < m_nodes.size(); i++)
+		delete m_nodes[i].job;
+}
+
+int JobGraph::addJob(void *(*pFunc)(void*), void *pArgs, int iPriority)
+{
+	ThreadData* pThreadData = threadDataManager.getOrCreateThreadData();
+	m_lock = pThreadData->getLock();
+	m_condDone = pThreadData->getCondVar();
+	
+	Node node;
+	node.job = new InnerJob(pFunc, pArgs, pThreadData, iPriority);
+	node.job->setGraph(this, (int)m_nodes.size());
+	node.predecessors = 0;
+	node.pending = 0;
+	m_nodes.push_back(node);
+	return (int)m_nodes.size() - 1;
+}
+
+void JobGraph::addDependency(int iBefore, int iAfter)
+{
+	m_nodes[iBefore].successors.push_back(iAfter);
+	m_nodes[iAfter].predecessors++;
+}
+
+bool JobGraph::isAcyclic() const
+{
+	// Kahn's algorithm: every job must eventually lose all its predecessors
+	vector<int> pending(m_nodes.size());
+	vector<int> ready;
+	for (unsigned int i = 0; i < m_nodes.size(); i++) {
+		pending[i] = m_nodes[i].predecessors;
+		if (pending[i] == 0)
+			ready.push_back(i);
+	}
+	unsigned int iVisited = 0;
+	while (!ready.empty()) {
+		int iJob = ready.back();
+		ready.pop_back();
+		iVisited++;
+		for (unsigned int s = 0; s < m_nodes[iJob].successors.size(); s++)
+			if (--pending[m_nodes[iJob].successors[s]] == 0)
+				ready.push_back(m_nodes[iJob].successors[s]);
+	}
+	return iVisited == m_nodes.size();
+}
+
+void JobGraph::start(vector<InnerJob*>& roots, BiModalScheduler* bounded)
+{
+	m_iRemaining = (int)m_nodes.size();
+	m_bounded = bounded;
+	m_ready.clear();
+	for (unsigned int i = 0; i < m_nodes.size(); i++) {
+		m_nodes[i].pending = m_nodes[i].predecessors;
+		if (m_nodes[i].pending == 0)
+			roots.push_back(m_nodes[i].job);
+	}
+}
+
+void JobGraph::onJobCommitted(int iJob, RunnerThread* runner)
+{
+	vector<InnerJob*> ready;
+	// the lock belongs to the submitter, not to the graph
+	pthread_mutex_t* lock = m_lock;
+	
+	pthread_mutex_lock(lock);
+	Node& node = m_nodes[iJob];
+	for (unsigned int s = 0; s < node.successors.size(); s++) {
+		Node& succ = m_nodes[node.successors[s]];
+		if (--succ.pending == 0)
+			ready.push_back(succ.job);
+	}
+	// when bounded, the job hands its slot over to the first ready job, and
+	// the others run alongside if there is room
+	if (m_bounded) {
+		m_ready.insert(m_ready.end(), ready.begin(), ready.end());
+		ready.clear();
+		if (!m_ready.empty()) {
+			ready.push_back(m_ready.front());
+			m_ready.pop_front();
+			m_bounded->admitGraphJobs(*this, runner->getCoreID());
+		} else if (m_iRemaining > 1) {
+			// the slot of the last job is released by scheduleGraph
+			m_bounded->onJobDone();
+		}
+	}
+	// once the last job is accounted for, the submitter may free the graph
+	if (--m_iRemaining == 0)
+		pthread_cond_signal(m_condDone);
+	pthread_mutex_unlock(lock);
+	
+	// nothing of the graph may be touched from here on, but the jobs in ready
+	// have not committed, so the graph can't have been freed yet
+	for (unsigned int i = 0; i < ready.size(); i++)
+		runner->addJob(ready[i]);
+}
+
+void JobGraph::waitForAll()
+{
+	pthread_mutex_lock(m_lock);
+	while (m_iRemaining > 0)
+	{
+		pthread_cond_wait(m_condDone, m_lock);
+	}
+	pthread_mutex_unlock(m_lock);
+}
@@ -0,0 +1,94 @@
+/*
+ * A graph of jobs with dependency edges. A job is released to a runner 
+ * queue only after all its predecessors have committed, and it is queued on
+ * the core whose runner committed the last of them, where the data the 
+ * predecessors touched is still in cache.
+ * 
+ * A job may read the result of any of its predecessors with getResult().
+ * 
+ * In a bounded scheduler every job queued or running holds an admission
+ * slot. A ready job that finds no room waits in the graph for the slot of
+ * the next job of the graph to commit.
+ * 
+ */
+
+#ifndef __STM_JOB_GRAPH__
+#define __STM_JOB_GRAPH__
+
+#include <vector>
+#include <deque>
+#include <pthread.h>
+#include "Queue.h"
+
+namespace stm
+{
+	namespace scheduler
+	{
+		class RunnerThread;
+		class BiModalScheduler;
+		
+		class JobGraph
+		{
+		private:
+			friend class BiModalScheduler;
+			friend class RunnerThread;
+			
+			class Node
+			{
+			public:
+				InnerJob* job;
+				std::vector<int> successors;
+				// Number of predecessors, and of those that have not committed yet
+				int predecessors;
+				int pending;
+			};
+			
+			std::vector<Node> m_nodes;
+			
+			// The submitting thread's lock and cond var
+			pthread_mutex_t* m_lock;
+			pthread_cond_t* m_condDone;
+			
+			// Jobs that have not committed yet
+			int m_iRemaining;
+			
+			// The bounded scheduler the graph runs in, NULL if unbounded, and
+			// the ready jobs that wait there for a slot
+			BiModalScheduler* m_bounded;
+			std::deque<InnerJob*> m_ready;
+			
+			// Returns false if the edges form a cycle
+			bool isAcyclic() const;
+			
+			// Resets the dependency counters before a submission, returns the jobs to queue
+			void start(std::vector<InnerJob*>& roots, BiModalScheduler* bounded);
+			
+			/*
+			 * Called by the runner that committed a job of the graph: queues the
+			 * successors that became ready on that runner. When bounded, the
+			 * job's slot goes to the first ready job waiting for one, and the
+			 * others are queued if there is room.
+			 */
+			void onJobCommitted(int iJob, RunnerThread* runner);
+			
+			void waitForAll();
+			
+		public:
+			JobGraph();
+			~JobGraph();
+			
+			// Adds a job to the graph and returns its index, must be called by the submitting thread
+			int addJob(void *(*pFunc)(void*), void *pArgs, int iPriority = 0);
+			
+			// iAfter won't start before iBefore has committed
+			void addDependency(int iBefore, int iAfter);
+			
+			// The value returned by the job, valid once it has committed
+			void *getResult(int iJob) { return m_nodes[iJob].job->getResult(); }
+			
+			int size() const { return (int)m_nodes.size(); }
+		};
+	}
+}
+
+#endif //__STM_JOB_GRAPH__
@@ -101,3 +101,41 @@ void Queue::pop()
 	}
 }
 
+
+int Queue::lowestPriority(int iBelow) const
+{
+	int iLowest = iBelow;
+	for (Node* cur = first; cur != 0; cur = cur->next)
+		if (cur->data->isSheddable() && cur->data->getPriority() < iLowest)
+			iLowest = cur->data->getPriority();
+	return iLowest;
+}
+
+InnerJob* Queue::removeLowestPriority(int iBelow)
+{
+	Node* victimPrev = 0;
+	Node* victim = 0;
+	Node* prev = 0;
+	// '<=' so that among equal priorities the youngest job is shed
+	for (Node* cur = first; cur != 0; prev = cur, cur = cur->next)
+		if (cur->data->isSheddable() && cur->data->getPriority() < iBelow &&
+			(!victim || cur->data->getPriority() <= victim->data->getPriority()))
+		{
+			victim = cur;
+			victimPrev = prev;
+		}
+	if (!victim)
+		return 0;
+
+	if (victimPrev)
+		victimPrev->next = victim->next;
+	else
+		first = victim->next;
+	if (last == victim)
+		last = victimPrev;
+	mySize--;
+
+	InnerJob* job = victim->data;
+	delete victim;
+	return job;
+}
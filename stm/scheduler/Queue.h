@@ -8,6 +8,7 @@
 
 #include <pthread.h>
 #include "ThreadData.h"
+#include "scheduler_common.h"
 
 #include <iostream>
 
@@ -15,6 +16,8 @@ namespace stm
 {
 	namespace scheduler
 	{
+		class JobGraph;
+		
 		// An inner class that represents a job that needs to be done
 		class InnerJob
 		{
@@ -32,6 +35,16 @@ namespace stm
 			time_t m_timestamp;
 			bool m_isRO;
 
+			/*
+			 * Admission related fields
+			 */
+			int m_iPriority;
+			int m_iStatus;
+			
+			// Set when the job belongs to a JobGraph
+			JobGraph* m_graph;
+			int m_iGraphNode;
+
 			// condition variable 
 			pthread_mutex_t* m_jobLock;
 			pthread_cond_t* m_condJobFinished;
@@ -39,16 +52,37 @@ namespace stm
 			int m_iJobID;
 
 		public:
-			InnerJob(void *(*pFunc)(void*), void *pArgs, ThreadData* pThreadData) 
+			InnerJob(void *(*pFunc)(void*), void *pArgs, ThreadData* pThreadData, int iPriority = 0) 
 				: m_pFunc(pFunc), m_pArgs(pArgs), m_blnFinished(false), m_result(0), m_epoch(-1), m_timestamp(NULL),
+					m_iPriority(iPriority), m_iStatus(SCHEDULE_OK), m_graph(NULL), m_iGraphNode(-1),
 					m_jobLock(pThreadData->getLock()), m_condJobFinished(pThreadData->getCondVar()), m_iJobID(++m_iAllJobsIDs)
 			{
 			}
 
+			// Runs the job, the submitter is only told by finish()
 			void execute()
 			{
 				m_result = (*m_pFunc)(m_pArgs);
+			}
+			
+			/*
+			 * Wakes the submitter of a job that is not part of a graph (the graph
+			 * wakes its own submitter). The submitter may free the job right away,
+			 * so the caller must be done with it.
+			 */
+			void finish()
+			{
+				pthread_mutex_lock(m_jobLock);
+				m_blnFinished = true;
+				pthread_cond_signal(m_condJobFinished);
+				pthread_mutex_unlock(m_jobLock);
+			}
+			
+			// Finishes the job without running it, the waiting thread gets iStatus
+			void cancel(int iStatus)
+			{
 				pthread_mutex_lock(m_jobLock);
+				m_iStatus = iStatus;
 				m_blnFinished = true;
 				pthread_cond_signal(m_condJobFinished);
 				pthread_mutex_unlock(m_jobLock);
@@ -80,6 +114,20 @@ namespace stm
 				return m_epoch;
 			}
 			
+			void *getResult() { return m_result; }
+			
+			// Jobs running the same function are taken to be of the same type
+			void *(*getFunc())(void*) { return m_pFunc; }
+			
+			void setGraph(JobGraph* graph, int iNode) { m_graph = graph; m_iGraphNode = iNode; }
+			JobGraph* getGraph() { return m_graph; }
+			int getGraphNode() { return m_iGraphNode; }
+			// Jobs of a graph are never shed, their successors wait for them
+			bool isSheddable() { return m_graph == NULL; }
+			
+			int getPriority() { return m_iPriority; }
+			int getStatus() { return m_iStatus; }
+			
 			void setTxRO(bool value) {m_isRO = value;}
 			bool isTxRO() { return m_isRO;}
 			void setTxTimestamp(time_t stamp) {m_timestamp = stamp;}
@@ -110,6 +158,12 @@ namespace stm
 
 			void pop();
 			
+			// Lowest priority among the queued jobs, or iBelow if no job is lower
+			int lowestPriority(int iBelow) const;
+			
+			// Unlinks and returns the youngest job with the lowest priority below iBelow, NULL if none
+			InnerJob* removeLowestPriority(int iBelow);
+			
 			const int& size() { return mySize; }
 
 
@@ -7,14 +7,15 @@
 
 #include "scheduler_common.h"
 #include "BiModalScheduler.h"
+#include "JobGraph.h"
 #include "rstm.h" /* for stm::init - initializing stm threads */
 #include "atomic_ops.h"
 
 using namespace std;
 using namespace stm::scheduler;
 
-RunnerThread::RunnerThread(const int iCpuID) 
-	: m_iCoreID(iCpuID), m_blnShouldShutdown(false)
+RunnerThread::RunnerThread(BiModalScheduler* scheduler, const int iCoreID, const int iCpuID) 
+	: m_scheduler(scheduler), m_iCoreID(iCoreID), m_iCpuID(iCpuID), m_blnShouldShutdown(false), m_blnClaimed(false), m_lngStmId(0), m_iSmtRank(0), m_lngFilterSeq(0)
 {
 	// Initialize the thread queue
 	m_queue = new Queue();
@@ -68,10 +69,12 @@ void RunnerThread::threadStart()
 {
 
 	// Set thread affinity
-	setAffinity(m_iCoreID);
+	setAffinity(m_iCpuID);
 
-	// Introduce the thread to the stm
+	// Introduce the thread to the stm, and tell its descriptor which scheduler and core it serves
 	stm::init("Bimodal", "vis-eager", false);
+	m_lngStmId = stm::idManager.getThreadId();
+	stm::internal::get_descriptor()->attachScheduler(m_scheduler, m_iCoreID);
 	doJobs();
 }
 
@@ -89,89 +92,194 @@ void RunnerThread::setAffinity(int iCpuID)
 
 void RunnerThread::doJobs()
 {			
-	while (!(BiModalScheduler::instance()->m_Instance)){};
-
 	while (1)
 	{
-		// Waiting for a job
-		while (!m_currJob) {
-			long epoch = *BiModalScheduler::instance()->m_epoch;
+		// Waiting for a job, the core may also be lent to a caller that runs a job inline
+		while (!m_currJob || m_blnClaimed) {
+			if (m_blnClaimed)
+				continue;
+			long epoch = *m_scheduler->m_epoch;
 			if (IS_READING(epoch)) {
 				/*
-				 * If we are in a reading epoch, we have to take a job in the ro queue
+				 * If we are in a reading epoch, we have to take a job in the ro queue.
+				 * The queue lock keeps callers from claiming the core meanwhile.
 				 */
-				int count = *BiModalScheduler::instance()->m_roQueueCount;
-				if (count > 1) {
-					if (bool_cas((volatile long unsigned int*)BiModalScheduler::instance()->m_roQueueCount,count, count - 1)) {
-						m_currJob = BiModalScheduler::instance()->roQueueDeque();
-						m_currJob->setEpoch(epoch);
-						} else continue;
-				}
-				else
-					if (bool_cas((volatile long unsigned int*)BiModalScheduler::instance()->m_roQueueCount,1,0)) {
-						m_currJob = BiModalScheduler::instance()->roQueueDeque();
-						m_currJob->setEpoch(epoch);
-						// If this is the last job to take in the ro queue, we change the epoch
-						bool_cas((volatile long unsigned int*)BiModalScheduler::instance()->m_epoch, epoch, epoch +1);
-					} else continue;
+				pthread_mutex_lock(&m_queueLock);
+				if (!m_blnClaimed)
+					takeROJob(epoch);
+				pthread_mutex_unlock(&m_queueLock);
 			} else {
 				/*
 				 * If we are in a writing epoch we first check if we have to go to a reading epoch
 				 */
-				if (BiModalScheduler::instance()->m_roQueue->size() >= BiModalScheduler::instance()->getCoresNum()
-					|| BiModalScheduler::instance()->allQueuesEmpty()) {
-					if (BiModalScheduler::instance()->m_roQueue->size() != 0)
-						if (bool_cas((volatile long unsigned int*)BiModalScheduler::instance()->m_epoch, epoch, epoch +1)){
+				if (m_scheduler->m_roQueue->size() >= m_scheduler->getCoresNum()
+					|| m_scheduler->allQueuesEmpty()) {
+					if (m_scheduler->m_roQueue->size() != 0)
+						if (bool_cas((volatile long unsigned int*)m_scheduler->m_epoch, epoch, epoch +1)){
 							// we set the number of transactions to take from the ro queue
-							if (BiModalScheduler::instance()->m_roQueue->size() < BiModalScheduler::instance()->getCoresNum()) {
-								BiModalScheduler::instance()->increaseAllQueueEmptyCounter();
+							if (m_scheduler->m_roQueue->size() < m_scheduler->getCoresNum()) {
+								m_scheduler->increaseAllQueueEmptyCounter();
 							}
-							*BiModalScheduler::instance()->m_roQueueCount = 
-								min(BiModalScheduler::instance()->getCoresNum(), (long)BiModalScheduler::instance()->m_roQueue->size());
+							*m_scheduler->m_roQueueCount = 
+								min(m_scheduler->getCoresNum(), (long)m_scheduler->m_roQueue->size());
 						}	
 							
 					continue;
 				} else {
 					// if we are in a writing epoch and have a job, we execute it
 					if (!m_queue->empty()) {
+						bool blnDequeued = false;
 						pthread_mutex_lock(&m_queueLock);
-						m_currJob = m_queue->front();
-						m_currJob->setEpoch(epoch);
+						// the queue may have been claimed or shed since we looked
+						if (!m_blnClaimed && !m_queue->empty()) {
+							m_currJob = m_queue->front();
+							m_currJob->setEpoch(epoch);
 			
-						m_queue->pop(); // Remove the job from the queue
+							m_queue->pop(); // Remove the job from the queue
+							blnDequeued = true;
+						}
 						pthread_mutex_unlock(&m_queueLock);
+						if (blnDequeued)
+							m_scheduler->onJobDequeued();
 					}
 				}
 			}
 				
 		}
+		// the spin above reads m_currJob and m_blnClaimed without the lock, a
+		// caller may have claimed the core in between. tryClaim sets both
+		// under the lock, so check them again there.
+		pthread_mutex_lock(&m_queueLock);
+		bool blnOwnJob = m_currJob && !m_blnClaimed;
+		pthread_mutex_unlock(&m_queueLock);
+		if (!blnOwnJob)
+			continue;
+		/*
+		 * Once told, the submitter frees the job, and the submitter of a graph
+		 * frees the whole graph after its last job. Everything we need from
+		 * them is read now, and they are told last.
+		 */
+		InnerJob* job = m_currJob;
+		JobGraph* graph = job->getGraph();
+		int iGraphNode = job->getGraphNode();
+		void *(*pFunc)(void*) = job->getFunc();
+		bool blnCommitted = false;
 		try
 		{
 			// Execute the job
 			//cout << "executing job" << endl;
-			m_currJob->execute();
+			job->execute();
+			blnCommitted = true;
 		}
 		catch (RescheduleException) // If a rescheduling has happened just move on to the next job
 		{
 		}
+		endPrediction(blnCommitted, pFunc);
 		m_currJob = NULL;
+		if (blnCommitted) {
+			if (graph)
+				graph->onJobCommitted(iGraphNode, this);
+			else {
+				m_scheduler->onJobDone();
+				job->finish();
+			}
+		}
 	}
   
 }
 
-void *RunnerThread::addJob(void *(*pFunc)(void*), void *pArgs, ThreadData* pThreadData)
+/*
+ * Takes a job from the ro queue if there are still some to take in this epoch.
+ * Called with m_queueLock held.
+ */
+void RunnerThread::takeROJob(long epoch)
 {
-	InnerJob* newJob = new InnerJob(pFunc, pArgs, pThreadData);
+	int count = *m_scheduler->m_roQueueCount;
+	// spread the batch across physical cores first, hyperthread siblings only
+	// help with what is left once every physical core can have a job
+	if (m_iSmtRank > 0 && count <= m_scheduler->m_iPhysicalCoresNum)
+		return;
+	if (count > 1) {
+		if (bool_cas((volatile long unsigned int*)m_scheduler->m_roQueueCount,count, count - 1)) {
+			m_currJob = m_scheduler->roQueueDeque();
+			m_currJob->setEpoch(epoch);
+		}
+	}
+	else
+		if (bool_cas((volatile long unsigned int*)m_scheduler->m_roQueueCount,1,0)) {
+			m_currJob = m_scheduler->roQueueDeque();
+			m_currJob->setEpoch(epoch);
+			// If this is the last job to take in the ro queue, we change the epoch
+			bool_cas((volatile long unsigned int*)m_scheduler->m_epoch, epoch, epoch +1);
+		}
+}
 
+bool RunnerThread::tryClaim(InnerJob *job, long epoch)
+{
+	bool blnClaimed = false;
+	pthread_mutex_lock(&m_queueLock);
+	if (!m_blnClaimed && !m_currJob && m_queue->empty()) {
+		job->setEpoch(epoch);
+		// the runner spins on both fields without the lock, it must never
+		// see the job before the claim
+		m_blnClaimed = true;
+		cfence();
+		m_currJob = job;
+		blnClaimed = true;
+	}
+	pthread_mutex_unlock(&m_queueLock);
+	return blnClaimed;
+}
+
+bool RunnerThread::runClaimed()
+{
+	bool blnDone = false;
+	InnerJob* job = m_currJob;
+	void *(*pFunc)(void*) = job->getFunc();
+	// Act as this runner towards the stm, the runner itself is parked until we release it
+	unsigned long lngOwnId = stm::idManager.adoptThreadId(m_lngStmId);
+	try
+	{
+		job->execute();
+		blnDone = true;
+	}
+	catch (RescheduleException) // The job was moved to another queue, a runner will finish it
+	{
+	}
+	stm::idManager.adoptThreadId(lngOwnId);
+	endPrediction(blnDone, pFunc);
+
+	pthread_mutex_lock(&m_queueLock);
+	m_currJob = NULL;
+	m_blnClaimed = false;
+	pthread_mutex_unlock(&m_queueLock);
+	if (blnDone)
+		job->finish();
+	return blnDone;
+}
+
+void RunnerThread::addJob(InnerJob *newJob)
+{
 	// Add the job to the queue
 	pthread_mutex_lock(&m_queueLock);
 	m_queue->push(newJob);
 	pthread_mutex_unlock(&m_queueLock);
+}
+
+int RunnerThread::lowestQueuedPriority(int iBelow)
+{
+	pthread_mutex_lock(&m_queueLock);
+	int iLowest = m_queue->lowestPriority(iBelow);
+	pthread_mutex_unlock(&m_queueLock);
+	return iLowest;
+}
 
-	// wait for the job to end
-	void* result = newJob->waitForFinish();
-	delete newJob;
-	return result;
+InnerJob* RunnerThread::shedJob(int iBelow)
+{
+	pthread_mutex_lock(&m_queueLock);
+	InnerJob* victim = m_queue->removeLowestPriority(iBelow);
+	pthread_mutex_unlock(&m_queueLock);
+	return victim;
 }
 
 void RunnerThread::moveJob(InnerJob *jobMoved)
@@ -195,6 +303,37 @@ void RunnerThread::shutdown()
 
 void RunnerThread::moveJobToROQueue() {
 	if (m_currJob)
-		BiModalScheduler::instance()->moveJobToROQueue(m_currJob);
+		m_scheduler->moveJobToROQueue(m_currJob);
+}
+
+void RunnerThread::endPrediction(bool blnCommitted, void *(*pFunc)(void*))
+{
+	if (!m_scheduler->m_config.m_blnPredictConflicts)
+		return;
+	// a rescheduled job has not finished, the runner that commits it will learn from it
+	if (blnCommitted)
+		m_scheduler->learnAccesses(pFunc, m_accesses);
+	m_lngFilterSeq++;
+	cfence();
+	m_recentWrites = m_writes;
+	m_writes.clear();
+	cfence();
+	m_lngFilterSeq++;
+	m_accesses.clear();
 }
 
+bool RunnerThread::mayConflict(const BloomFilter& accesses)
+{
+	// the bits of the running job may arrive as we look, but a roll over must
+	// not be seen half done
+	while (true) {
+		unsigned long lngSeq = m_lngFilterSeq;
+		if (lngSeq % 2)
+			continue;
+		cfence();
+		bool blnConflict = m_writes.intersects(accesses) || m_recentWrites.intersects(accesses);
+		cfence();
+		if (m_lngFilterSeq == lngSeq)
+			return blnConflict;
+	}
+}
@@ -9,19 +9,28 @@
 #include <string>
 #include <pthread.h>
 #include "Queue.h"
+#include "BloomFilter.h"
 #include <iostream>
 
 namespace stm
 {
 	namespace scheduler
 	{
+		class BiModalScheduler;
+		
 		// The runner thread is a thread that runs on a single cpu and runs transactions given to it in a queue
 		class RunnerThread
 		{
 		private:
 
-			// Holds the core number this thread associates to
+			// The scheduler this thread belongs to
+			BiModalScheduler* m_scheduler;
+
+			// Holds the core number this thread associates to, i.e. its index in the scheduler
 			int m_iCoreID;
+			
+			// The cpu this thread is pinned to
+			int m_iCpuID;
 
 			// The thread itself
 			pthread_t m_thread;
@@ -32,9 +41,40 @@ namespace stm
 			// queue lock
 			pthread_mutex_t m_queueLock;
 
-			InnerJob *m_currJob;
+			InnerJob * volatile m_currJob;
 
 			bool m_blnShouldShutdown;
+			
+			// Set while a submitting thread runs m_currJob inline under this runner's identity
+			volatile bool m_blnClaimed;
+			
+			// The stm thread id this runner registered with
+			unsigned long m_lngStmId;
+			
+			// 0 for the first runner of a physical core, 1 for its first hyperthread sibling...
+			int m_iSmtRank;
+			
+			/*
+			 * Conflict prediction: the objects written by the current job and
+			 * by the previous one, and the objects the current job accessed.
+			 * m_lngFilterSeq is odd while endPrediction rolls the write filters
+			 * over, so that mayConflict in another thread can retry.
+			 */
+			BloomFilter m_writes;
+			BloomFilter m_recentWrites;
+			BloomFilter m_accesses;
+			volatile unsigned long m_lngFilterSeq;
+			
+			/*
+			 * Hands the accesses of the job, of type pFunc, to the scheduler if it
+			 * committed, and starts afresh. The job itself may be gone already.
+			 */
+			void endPrediction(bool blnCommitted, void *(*pFunc)(void*));
+			
+			/*
+			 * Takes a job from the scheduler ro queue, if any is left for this epoch
+			 */
+			void takeROJob(long epoch);
 			/*
 			 * Sets the cpu/core affinity that current process will use.
 			 */
@@ -50,7 +90,7 @@ namespace stm
 
 		public:
 
-			RunnerThread(const int iCpuID);
+			RunnerThread(BiModalScheduler* scheduler, const int iCoreID, const int iCpuID);
 
 			// D'tor
 			~RunnerThread();
@@ -60,8 +100,26 @@ namespace stm
 			// The method that will be called when a thread starts
 			void threadStart();
 
-			// Adds an external job (transaction) that the thread needs to perform
-			void *addJob(void *(*pFunc)(void*), void *pArgs, ThreadData* pThreadData);
+			// Adds an external job (transaction) that the thread needs to perform, the caller waits for it
+			void addJob(InnerJob *newJob);
+			
+			/*
+			 * Lends this core to the calling thread for job, if the core is idle
+			 * and nothing waits in its queue
+			 */
+			bool tryClaim(InnerJob *job, long epoch);
+			
+			/*
+			 * Runs the claimed job in the calling thread and releases the core.
+			 * Returns false if the job was rescheduled and must still be waited for.
+			 */
+			bool runClaimed();
+			
+			// Lowest priority waiting in this thread's queue, or iBelow if none is lower
+			int lowestQueuedPriority(int iBelow);
+			
+			// Removes the lowest priority queued job below iBelow, NULL if there is none
+			InnerJob* shedJob(int iBelow);
 
 			// Moves the job that currently runs to the given core
 			void moveJob(RunnerThread *otherThread);
@@ -80,6 +138,21 @@ namespace stm
 			
 			
 			const int& getJobsNum() { return m_queue->size(); }
+			
+			bool isIdle() { return !m_currJob && m_queue->empty(); }
+			
+			int getCpuID() { return m_iCpuID; }
+			
+			int getCoreID() { return m_iCoreID; }
+			
+			void setSmtRank(int iRank) { m_iSmtRank = iRank; }
+			
+			// Fed by the descriptor of this runner as its transaction opens objects
+			void noteRead(const void* addr) { m_accesses.add(addr); }
+			void noteWrite(const void* addr) { m_accesses.add(addr); m_writes.add(addr); }
+			
+			// True if a job accessing these objects may conflict with our current or recent writes
+			bool mayConflict(const BloomFilter& accesses);
 
 		};
 	}
@@ -0,0 +1,59 @@
+/*
+ * Tunables of the BiModal scheduler. A configuration is handed to the
+ * constructor of a scheduler instance, or to BiModalScheduler::configure()
+ * before the first call to init() for the default instance.
+ * 
+ */
+
+#ifndef __STM_SCHEDULERCONFIG__
+#define __STM_SCHEDULERCONFIG__
+
+#include <vector>
+
+namespace stm {
+	namespace scheduler {
+		
+		// What to do with a submission when the queues are full
+		enum AdmissionMode {
+			ADMIT_BLOCK,		// wait for room, up to m_lngBlockTimeoutMs
+			ADMIT_FAIL_FAST,	// return SCHEDULE_BUSY immediately
+			ADMIT_SHED			// drop the lowest priority queued job, or the new one
+		};
+		
+		class SchedulerConfig {
+			public:
+			
+				// Max jobs waiting in a single core queue, 0 for unbounded
+				int m_iCoreCapacity;
+				// Max jobs admitted and not yet finished in the whole scheduler, 0 for unbounded
+				long m_lngGlobalCapacity;
+				AdmissionMode m_admission;
+				// How long a blocked submission waits for room, 0 to wait forever
+				long m_lngBlockTimeoutMs;
+				// Run a job in the submitting thread when its core is idle in a writing epoch
+				bool m_blnCallerRuns;
+				// Let read-only jobs of a reading epoch skip validation and read
+				// logging while no other transaction runs. Every transaction on
+				// the shared data must then go through this instance: those of
+				// threads outside it are not counted, and nothing keeps them from
+				// writing under a fast reader.
+				bool m_blnFastReads;
+				// Queue a job behind a running core that recently wrote objects the
+				// job accessed the last time it ran
+				bool m_blnPredictConflicts;
+				// The cpus the runners are pinned to, all online cpus when empty.
+				// Instances that share data must not share cpus.
+				std::vector<int> m_cpus;
+			
+				SchedulerConfig() : m_iCoreCapacity(0), m_lngGlobalCapacity(0),
+				m_admission(ADMIT_BLOCK), m_lngBlockTimeoutMs(0), m_blnCallerRuns(false),
+				m_blnFastReads(false), m_blnPredictConflicts(false) {}
+				
+				bool isBounded() const { return m_iCoreCapacity > 0 || m_lngGlobalCapacity > 0; }
+		};
+		
+	}
+}
+
+
+#endif //__STM_SCHEDULERCONFIG__
@@ -14,15 +14,37 @@ namespace stm {
 				long numFalsePositive;
 				long numAllQueueEmpty;
 				long numPushToRO;
+				// Admission control
+				long numRejected;
+				long numThrottled;
+				long numTimedOut;
+				long numShed;
+				// Caller-runs
+				long numInline;
+				long numInlineRescheduled;
+				// Fast reads
+				unsigned long numFastReads;
+				long numFastReadFallbacks;
+				// Conflict prediction
+				long numPredicted;
 			
 				SchedulerStatistics() : finalEpoch(0), numConflicts(0), 
-				numFalsePositive(0), numAllQueueEmpty(0), numPushToRO(0) {}
+				numFalsePositive(0), numAllQueueEmpty(0), numPushToRO(0),
+				numRejected(0), numThrottled(0), numTimedOut(0), numShed(0),
+				numInline(0), numInlineRescheduled(0), numFastReads(0),
+				numFastReadFallbacks(0), numPredicted(0) {}
 				void printStats() {
 					std::cout << "Final Epoch: " << finalEpoch << "\n"
 					<< "Number of conflicts: " << numConflicts << "\n"
 					<< "Number of false positives: " << numFalsePositive << "\n"
 					<< "Scheduler went to read epoch because all queues were empty " << numAllQueueEmpty << " times\n"
-					<< numPushToRO << " transactions passed through the RO queue\n" ;
+					<< numPushToRO << " transactions passed through the RO queue\n"
+					<< "Rejected submissions: " << numRejected << " (" << numTimedOut << " timed out)\n"
+					<< "Throttled submissions: " << numThrottled << "\n"
+					<< "Queued jobs shed: " << numShed << "\n"
+					<< "Jobs run by the caller: " << numInline << " (" << numInlineRescheduled << " handed to a runner)\n"
+					<< "Fast read transactions: " << numFastReads << " (" << numFastReadFallbacks << " turned out to write)\n"
+					<< "Jobs queued behind a predicted conflict: " << numPredicted << "\n" ;
 				}
 		};
 		
@@ -48,6 +48,18 @@ namespace stm
 					return reinterpret_cast<ThreadData*>(pthread_getspecific(m_threadKey));
 				}
 
+				// The calling thread's data, created on first use
+				ThreadData* getOrCreateThreadData()
+				{
+					ThreadData* pThreadData = getThreadData();
+					if (!pThreadData)
+					{
+						pThreadData = new ThreadData();
+						setThreadData(pThreadData);
+					}
+					return pThreadData;
+				}
+
 				void setThreadData(ThreadData* pThreadData)
 				{
 					pthread_setspecific(m_threadKey, reinterpret_cast<void*>(pThreadData));
@@ -0,0 +1,105 @@
+#include "Topology.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+
+using namespace std;
+using namespace stm::scheduler;
+
+static string cpuPath(int iCpu, const char* file)
+{
+	char path[128];
+	snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d/%s", iCpu, file);
+	return path;
+}
+
+int Topology::readInt(const string& path, int iDefault)
+{
+	FILE* f = fopen(path.c_str(), "r");
+	if (!f)
+		return iDefault;
+	int iValue;
+	if (fscanf(f, "%d", &iValue) != 1)
+		iValue = iDefault;
+	fclose(f);
+	return iValue;
+}
+
+vector<int> Topology::readCpuList(const string& path)
+{
+	vector<int> cpus;
+	FILE* f = fopen(path.c_str(), "r");
+	if (!f)
+		return cpus;
+	char line[1024];
+	if (fgets(line, sizeof(line), f)) {
+		char* cur = line;
+		while (*cur && *cur != '\n') {
+			char* end;
+			int iFirst = strtol(cur, &end, 10);
+			if (end == cur)
+				break;
+			int iLast = iFirst;
+			if (*end == '-') {
+				cur = end + 1;
+				iLast = strtol(cur, &end, 10);
+			}
+			for (int i = iFirst; i <= iLast; i++)
+				cpus.push_back(i);
+			cur = end;
+			if (*cur == ',')
+				cur++;
+		}
+	}
+	fclose(f);
+	return cpus;
+}
+
+Topology::Topology(int iCpusNum) : m_cpus(iCpusNum), m_iPhysicalCores(0)
+{
+	for (int iCpu = 0; iCpu < iCpusNum; iCpu++) {
+		CpuInfo& info = m_cpus[iCpu];
+		info.socket = readInt(cpuPath(iCpu, "topology/physical_package_id"), 0);
+		
+		info.physicalCore = iCpu;
+		info.smtRank = 0;
+		vector<int> siblings = readCpuList(cpuPath(iCpu, "topology/thread_siblings_list"));
+		for (unsigned int i = 0; i < siblings.size(); i++) {
+			if (siblings[i] < info.physicalCore)
+				info.physicalCore = siblings[i];
+			if (siblings[i] < iCpu)
+				info.smtRank++;
+			if (siblings[i] != iCpu)
+				info.siblings.push_back(siblings[i]);
+		}
+		if (info.smtRank == 0)
+			m_iPhysicalCores++;
+		
+		// look for the cache index that describes the L3
+		info.l3Domain = 0;
+		for (int iIndex = 0; iIndex < 8; iIndex++) {
+			char file[64];
+			snprintf(file, sizeof(file), "cache/index%d/level", iIndex);
+			int iLevel = readInt(cpuPath(iCpu, file), -1);
+			if (iLevel < 0)
+				break;
+			if (iLevel != 3)
+				continue;
+			snprintf(file, sizeof(file), "cache/index%d/shared_cpu_list", iIndex);
+			vector<int> shared = readCpuList(cpuPath(iCpu, file));
+			if (!shared.empty())
+				info.l3Domain = shared[0];
+			break;
+		}
+	}
+}
+
+void Topology::print() const
+{
+	cout << "Topology: " << m_cpus.size() << " cpus on " << m_iPhysicalCores << " physical cores" << endl;
+	for (unsigned int iCpu = 0; iCpu < m_cpus.size(); iCpu++)
+		cout << "  cpu " << iCpu << ": socket " << m_cpus[iCpu].socket
+			<< ", core " << m_cpus[iCpu].physicalCore << " (smt " << m_cpus[iCpu].smtRank << ")"
+			<< ", l3 " << m_cpus[iCpu].l3Domain << endl;
+}
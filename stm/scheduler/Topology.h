@@ -0,0 +1,68 @@
+/*
+ * The machine topology as seen in /sys/devices/system/cpu: which cpus are
+ * SMT siblings, which share an L3 cache and which share a socket. 
+ * When the files can't be read every cpu is taken to be its own core, on a
+ * single socket with a single L3.
+ * 
+ */
+
+#ifndef __STM_TOPOLOGY__
+#define __STM_TOPOLOGY__
+
+#include <vector>
+#include <string>
+
+namespace stm
+{
+	namespace scheduler
+	{
+		class Topology
+		{
+		private:
+			class CpuInfo
+			{
+			public:
+				int socket;
+				// The lowest cpu sharing the physical core, and our rank among those cpus
+				int physicalCore;
+				int smtRank;
+				// The lowest cpu sharing the L3 cache
+				int l3Domain;
+				// The other cpus of the physical core
+				std::vector<int> siblings;
+			};
+			
+			std::vector<CpuInfo> m_cpus;
+			int m_iPhysicalCores;
+			
+			// Reads a single integer from a sysfs file, returns iDefault on failure
+			static int readInt(const std::string& path, int iDefault);
+			
+			// Reads a cpu list such as "0-3,8-11" from a sysfs file
+			static std::vector<int> readCpuList(const std::string& path);
+			
+		public:
+			Topology(int iCpusNum);
+			
+			int getCpusNum() const { return (int)m_cpus.size(); }
+			int getPhysicalCoresNum() const { return m_iPhysicalCores; }
+			
+			int getSocket(int iCpu) const { return m_cpus[iCpu].socket; }
+			int getPhysicalCore(int iCpu) const { return m_cpus[iCpu].physicalCore; }
+			int getSmtRank(int iCpu) const { return m_cpus[iCpu].smtRank; }
+			int getL3Domain(int iCpu) const { return m_cpus[iCpu].l3Domain; }
+			
+			const std::vector<int>& getSiblings(int iCpu) const { return m_cpus[iCpu].siblings; }
+			
+			bool areSiblings(int iCpu1, int iCpu2) const
+			{ return iCpu1 != iCpu2 && m_cpus[iCpu1].physicalCore == m_cpus[iCpu2].physicalCore; }
+			
+			bool shareL3(int iCpu1, int iCpu2) const
+			{ return m_cpus[iCpu1].l3Domain == m_cpus[iCpu2].l3Domain; }
+			
+			void print() const;
+		};
+	}
+}
+
+#endif //__STM_TOPOLOGY__
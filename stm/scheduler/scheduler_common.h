@@ -5,6 +5,12 @@
 #define IS_READING(epoch) epoch%2
 #define IS_WRITING(epoch) !(epoch%2)
 
+// A rescheduled job only leaves the winner's core when more jobs than this wait there
+#define RESCHEDULE_SPILL_JOBS 4
+
+// Per-core counters are this many longs apart, so no two share a cache line
+#define CORE_LINE_LONGS 16
+
 namespace stm {
 	namespace scheduler {
 		/*
@@ -12,6 +18,17 @@ namespace stm {
 		 */
 		class RescheduleException {
 		};
+
+		/*
+		 * The outcome of submitting a job to the scheduler
+		 */
+		enum ScheduleStatus {
+			SCHEDULE_OK,		// the job was admitted and has run
+			SCHEDULE_BUSY,		// the queues were full and the admission policy is fail-fast
+			SCHEDULE_TIMEOUT,	// the queues stayed full for the whole blocking timeout
+			SCHEDULE_SHED,		// the job was dropped in favour of a higher priority job
+			SCHEDULE_INVALID	// the job graph has a cycle
+		};
 	}
 }
 
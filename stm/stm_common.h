@@ -35,8 +35,13 @@
 #ifndef __STM_COMMON_H__
 #define __STM_COMMON_H__
 
+#include <string>
 #include "IdManager.h"
 
+#ifdef ABORT_LONGJMP
+#include <setjmp.h>
+#endif
+
 // the following bits are common to all implementations of the RSTM API
 namespace stm
 {
@@ -50,7 +55,8 @@ namespace stm
     static const int MAX_THREADS = 256;
 
     /**
-     *  When a tx needs to abort, it will throw this.
+     *  When a tx needs to abort, it will throw this, unless it was built
+     *  with ABORT_MECHANISM=LONGJMP.
      */
     class Aborted { };
 
@@ -83,6 +89,28 @@ namespace stm
      *  livelocked benchmark.
      */
     inline void halt_all_transactions() { terminate = true; }
+
+    /**
+     *  back this in stm.cpp: if nonzero, a thread whose transactions aborted
+     *  this many times in a row runs its next attempt under a global fallback
+     *  lock, so a livelock ends without halt_all_transactions().  Zero turns
+     *  the fallback off.  Only RSTM implements it.
+     */
+    extern unsigned long fallback_threshold;
+
+    inline void set_fallback_threshold(unsigned long aborts)
+    {
+        fallback_threshold = aborts;
+    }
+
+    /**
+     *  Make every contention manager back off with /strategy/ (spin,
+     *  exponential, yield or park) instead of its own, and wait between
+     *  attempts of an aborted transaction.  "" goes back to each CM's own
+     *  strategy.  Returns false for an unknown name.  Backed in
+     *  ContentionManager.cpp; cgl has no contention to back off from.
+     */
+    bool set_backoff_strategy(std::string strategy);
 };
 
 #endif // __STM_COMMON_H__